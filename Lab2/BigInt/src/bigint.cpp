@@ -14,36 +14,20 @@ namespace core
     {
     }
 
-    BigInt::BigInt(long long v) : d(), neg(false)
+    BigInt::BigInt(long long v) : d(), neg(v < 0)
     {
-        if (v < 0)
+        // magnitude in unsigned arithmetic, so LLONG_MIN needs no detour through temporaries
+
+        unsigned long long u = static_cast<unsigned long long>(v);
+        if (neg)
         {
-            neg = true;
-            if (v == std::numeric_limits<long long>::min())
-            {
-                long long q = v / 10;
-                long long r = v % 10;
-                if (q < 0)
-                {
-                    q = -q;
-                }
-                if (r < 0)
-                {
-                    r = -r;
-                }
-                BigInt t(q);
-                t = t * BigInt(10) + BigInt(r);
-                *this = t;
-                neg = true;
-                return;
-            }
-            v = -v;
+            u = 0ull - u;
         }
-        while (v > 0)
+        while (u > 0)
         {
-            uint32_t block = static_cast<uint32_t>(v % BASE);
+            uint32_t block = static_cast<uint32_t>(u % BASE);
             d.push_back(block);
-            v /= BASE;
+            u /= BASE;
         }
         trim();
     }
@@ -430,95 +414,156 @@ namespace core
             return;
         }
 
-        auto trim_vec = [](std::vector<uint32_t> &v)
+        size_t n = b.d.size();
+        size_t m = a.d.size() - n;
+
+        // single limb divisor: plain short division
+
+        if (n == 1)
         {
-            while (!v.empty() && v.back() == 0u)
+            uint64_t div = b.d[0];
+            uint64_t rem = 0;
+            q.d.assign(a.d.size(), 0u);
+            size_t i = a.d.size();
+            while (i > 0)
             {
-                v.pop_back();
+                uint64_t cur = rem * BASE + a.d[i - 1];
+                q.d[i - 1] = static_cast<uint32_t>(cur / div);
+                rem = cur % div;
+                i -= 1;
             }
-        };
+            r.d.clear();
+            if (rem != 0)
+            {
+                r.d.push_back(static_cast<uint32_t>(rem));
+            }
+            q.neg = false;
+            r.neg = false;
+            q.trim();
+            r.trim();
+            return;
+        }
+
+        // Knuth, TAOCP vol. 2, 4.3.1, Algorithm D
+        // normalize so that the top limb of the divisor is >= BASE / 2
+
+        uint64_t f = BASE / (static_cast<uint64_t>(b.d[n - 1]) + 1u);
+
+        std::vector<uint32_t> u(a.d.size() + 1, 0u);
+        std::vector<uint32_t> v(n, 0u);
+        uint64_t carry = 0;
+        size_t i = 0;
+        while (i < a.d.size())
+        {
+            uint64_t cur = a.d[i] * f + carry;
+            u[i] = static_cast<uint32_t>(cur % BASE);
+            carry = cur / BASE;
+            i += 1;
+        }
+        u[a.d.size()] = static_cast<uint32_t>(carry);
+        carry = 0;
+        i = 0;
+        while (i < n)
+        {
+            uint64_t cur = b.d[i] * f + carry;
+            v[i] = static_cast<uint32_t>(cur % BASE);
+            carry = cur / BASE;
+            i += 1;
+        }
 
-        q.d.assign(a.d.size(), 0u);
+        uint64_t vtop = v[n - 1];
+        uint64_t vnext = v[n - 2];
+
+        q.d.assign(m + 1, 0u);
         q.neg = false;
-        r.d.clear();
-        r.neg = false;
-        r.d.reserve(a.d.size());
 
-        size_t i = a.d.size();
-        while (i > 0)
+        size_t j = m + 1;
+        while (j > 0)
         {
-            r.d.insert(r.d.begin(), 0u);
-            r.d[0] = a.d[i - 1];
-            while (!r.d.empty() && r.d.back() == 0u)
-            {
-                r.d.pop_back();
-            }
+            j -= 1;
 
-            uint32_t low = 0;
-            uint32_t high = BASE - 1;
-            uint32_t best = 0;
+            // estimate the quotient limb from the top two limbs, at most two corrections
 
-            while (low <= high)
+            uint64_t num = static_cast<uint64_t>(u[j + n]) * BASE + u[j + n - 1];
+            uint64_t qhat = num / vtop;
+            uint64_t rhat = num % vtop;
+            while (qhat >= BASE || qhat * vnext > rhat * BASE + u[j + n - 2])
             {
-                uint32_t mid = static_cast<uint32_t>(low + (static_cast<uint64_t>(high - low) / 2));
-                std::vector<uint32_t> prod(b.d.size() + 1, 0u);
-                uint64_t carry = 0;
-                size_t j = 0;
-                while (j < b.d.size())
+                qhat -= 1;
+                rhat += vtop;
+                if (rhat >= BASE)
                 {
-                    uint64_t cur = static_cast<uint64_t>(b.d[j]) * mid + carry;
-                    prod[j] = static_cast<uint32_t>(cur % BASE);
-                    carry = cur / BASE;
-                    j += 1;
+                    break;
                 }
-                prod[b.d.size()] = static_cast<uint32_t>(carry);
-                trim_vec(prod);
+            }
 
-                std::vector<uint32_t> rr = r.d;
-                bool ok = sub_inplace(rr, prod);
-                if (ok)
+            // u[j .. j + n] -= qhat * v
+
+            int64_t borrow = 0;
+            carry = 0;
+            i = 0;
+            while (i < n)
+            {
+                uint64_t p = qhat * v[i] + carry;
+                carry = p / BASE;
+                int64_t s = static_cast<int64_t>(u[i + j]) - static_cast<int64_t>(p % BASE) - borrow;
+                if (s < 0)
                 {
-                    best = mid;
-                    low = mid + 1;
+                    s += BASE;
+                    borrow = 1;
                 }
                 else
                 {
-                    if (mid == 0)
-                    {
-                        break;
-                    }
-                    high = static_cast<uint32_t>(mid - 1);
+                    borrow = 0;
                 }
+                u[i + j] = static_cast<uint32_t>(s);
+                i += 1;
             }
+            int64_t top = static_cast<int64_t>(u[j + n]) - static_cast<int64_t>(carry) - borrow;
 
-            q.d[i - 1] = best;
+            // qhat was one too large: add the divisor back
 
-            if (best > 0)
+            if (top < 0)
             {
-                std::vector<uint32_t> prod(b.d.size() + 1, 0u);
-                uint64_t carry = 0;
-                size_t j = 0;
-                while (j < b.d.size())
+                qhat -= 1;
+                carry = 0;
+                i = 0;
+                while (i < n)
                 {
-                    uint64_t cur = static_cast<uint64_t>(b.d[j]) * best + carry;
-                    prod[j] = static_cast<uint32_t>(cur % BASE);
-                    carry = cur / BASE;
-                    j += 1;
+                    uint64_t s = static_cast<uint64_t>(u[i + j]) + v[i] + carry;
+                    if (s >= BASE)
+                    {
+                        s -= BASE;
+                        carry = 1;
+                    }
+                    else
+                    {
+                        carry = 0;
+                    }
+                    u[i + j] = static_cast<uint32_t>(s);
+                    i += 1;
                 }
-                prod[b.d.size()] = static_cast<uint32_t>(carry);
-                trim_vec(prod);
-                sub_inplace(r.d, prod);
+                top += static_cast<int64_t>(carry);
             }
-
-            i -= 1;
+            u[j + n] = static_cast<uint32_t>(top);
+            q.d[j] = static_cast<uint32_t>(qhat);
         }
 
-        while (!q.d.empty() && q.d.back() == 0u)
+        // remainder is u[0 .. n - 1] / f
+
+        r.d.assign(n, 0u);
+        uint64_t rem = 0;
+        i = n;
+        while (i > 0)
         {
-            q.d.pop_back();
+            uint64_t cur = rem * BASE + u[i - 1];
+            r.d[i - 1] = static_cast<uint32_t>(cur / f);
+            rem = cur % f;
+            i -= 1;
         }
-        r.neg = false;
+
         q.neg = false;
+        r.neg = false;
         q.trim();
         r.trim();
     }
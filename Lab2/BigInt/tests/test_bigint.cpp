@@ -138,3 +138,14 @@ TEST_F(BigIntFixture, LargeBlocksStability)
     EXPECT_EQ(a, b);
     EXPECT_EQ((a + BigInt(1)) > a, true);
 }
+
+TEST_F(BigIntFixture, DivisionMultiLimb)
+{
+    BigInt a("123456789012345678901234567890123456789012345678901234567890");
+    BigInt b("987654321098765432109876543210");
+    BigInt q = a / b;
+    EXPECT_EQ(q.to_string(), "124999998860937500014238281249");
+    BigInt r = a - q * b;
+    EXPECT_TRUE(r >= BigInt(0));
+    EXPECT_TRUE(r < b);
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "mod_exp.hpp"
+
+using core::BigInt;
+
+// Latency of mod_exp vs mod_exp_ct for 2048-bit exponents of increasing Hamming weight.
+// The ladder column should stay flat across weights; the windowed one grows with it.
+
+static BigInt random_odd(std::mt19937_64 &rng, size_t limbs)
+{
+    std::vector<uint64_t> v(limbs);
+    for (uint64_t &x : v)
+    {
+        x = rng();
+    }
+    v[0] |= 1u;
+    v[limbs - 1] |= uint64_t(1) << 63;
+    return BigInt::from_limbs(v);
+}
+
+// top bit set plus weight - 1 further bits spread over the remaining positions
+static BigInt exponent_with_weight(std::mt19937_64 &rng, size_t bits, size_t weight)
+{
+    std::vector<size_t> pos(bits - 1);
+    for (size_t i = 0; i < pos.size(); ++i)
+    {
+        pos[i] = i;
+    }
+    std::shuffle(pos.begin(), pos.end(), rng);
+    std::vector<uint64_t> v((bits + 63) / 64, 0u);
+    v[(bits - 1) / 64] |= uint64_t(1) << ((bits - 1) % 64);
+    for (size_t i = 0; i + 1 < weight; ++i)
+    {
+        v[pos[i] / 64] |= uint64_t(1) << (pos[i] % 64);
+    }
+    return BigInt::from_limbs(v);
+}
+
+template <typename F>
+static void measure(F f, int reps, double &mean, double &sd)
+{
+    std::vector<double> t;
+    for (int i = 0; i < reps; ++i)
+    {
+        auto a = std::chrono::steady_clock::now();
+        f();
+        auto b = std::chrono::steady_clock::now();
+        t.push_back(std::chrono::duration<double, std::milli>(b - a).count());
+    }
+    std::sort(t.begin(), t.end());
+    t.resize(t.size() - t.size() / 5); // drop the slowest fifth (scheduler noise)
+    mean = 0;
+    for (double x : t)
+    {
+        mean += x;
+    }
+    mean /= static_cast<double>(t.size());
+    sd = 0;
+    for (double x : t)
+    {
+        sd += (x - mean) * (x - mean);
+    }
+    sd = std::sqrt(sd / static_cast<double>(t.size()));
+}
+
+int main(int argc, char **argv)
+{
+    const size_t bits = 2048;
+    const int reps = argc > 1 ? std::atoi(argv[1]) : 20;
+    if (argc > 2 || reps < 1)
+    {
+        std::fprintf(stderr, "usage: %s [reps >= 1]\n", argv[0]);
+        return 2;
+    }
+    std::mt19937_64 rng(2024);
+    BigInt m = random_odd(rng, bits / 64);
+    BigInt base = random_odd(rng, bits / 64 - 1);
+    core::MontgomeryContext ctx(m);
+
+    core::mod_exp_ct(base, m, ctx); // warm up caches and the scratch buffers
+
+    std::printf("%8s %14s %14s %14s %14s\n", "weight", "window ms", "sd", "ladder ms", "sd");
+    double lo = 1e300;
+    double hi = 0;
+    for (size_t weight : {size_t(1), size_t(64), size_t(512), size_t(1024), size_t(1536), size_t(2048)})
+    {
+        BigInt e = exponent_with_weight(rng, bits, weight);
+        double wm = 0, ws = 0, lm = 0, ls = 0;
+        measure([&]() { core::mod_exp(base, e, ctx); }, reps, wm, ws);
+        measure([&]() { core::mod_exp_ct(base, e, ctx); }, reps, lm, ls);
+        lo = std::min(lo, lm);
+        hi = std::max(hi, lm);
+        std::printf("%8zu %14.3f %14.3f %14.3f %14.3f\n", weight, wm, ws, lm, ls);
+    }
+    std::printf("ladder spread across weights: %.2f%%\n", 100.0 * (hi - lo) / lo);
+    return 0;
+}
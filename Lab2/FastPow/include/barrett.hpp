@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "bigint.hpp"
+
+namespace core
+{
+
+    // Barrett reduction modulo any m > 1, mu = floor(2^(128k) / m) for a k-limb modulus.
+    // Residues are fixed-width vectors of k limbs holding a mod m, same interface as MontgomeryContext.
+    // The context is immutable after construction and can be shared between threads.
+
+    class BarrettContext
+    {
+    public:
+        explicit BarrettContext(const BigInt &mod);
+
+        const BigInt &modulus() const;
+        size_t width() const;
+
+        void to_residue(const BigInt &a, std::vector<uint64_t> &out) const;
+        BigInt from_residue(const std::vector<uint64_t> &a) const;
+        void one(std::vector<uint64_t> &out) const;
+
+        // r = a * b mod m; r may alias a or b
+        void mul(std::vector<uint64_t> &r, const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) const;
+        void sqr(std::vector<uint64_t> &r, const std::vector<uint64_t> &a) const;
+
+        BigInt mul(const BigInt &a, const BigInt &b) const;
+
+    private:
+        BigInt m;
+        std::vector<uint64_t> n;
+        size_t k;
+        std::vector<uint64_t> mu;
+
+        void reduce(std::vector<uint64_t> &r, uint64_t *t) const;
+    };
+
+}
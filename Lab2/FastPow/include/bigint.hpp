@@ -1,12 +1,65 @@
 #pragma once
+#include <charconv>
 #include <cstdint>
 #include <iosfwd>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace core
 {
 
+    // limb storage keeping up to INLINE_LIMBS limbs in place, so values below 2^128 never touch
+    // the heap; implements the part of the std::vector interface BigInt uses
+
+    class LimbVec
+    {
+    public:
+        static const size_t INLINE_LIMBS = 2;
+
+        LimbVec();
+        LimbVec(const LimbVec &other);
+        LimbVec(LimbVec &&other) noexcept;
+        LimbVec &operator=(const LimbVec &other);
+        LimbVec &operator=(LimbVec &&other) noexcept;
+        ~LimbVec();
+
+        size_t size() const;
+        bool empty() const;
+        size_t capacity() const;
+        uint64_t *data();
+        const uint64_t *data() const;
+        uint64_t *begin();
+        uint64_t *end();
+        const uint64_t *begin() const;
+        const uint64_t *end() const;
+        uint64_t &operator[](size_t i);
+        const uint64_t &operator[](size_t i) const;
+        uint64_t &back();
+        const uint64_t &back() const;
+
+        void push_back(uint64_t v);
+        void pop_back();
+        void clear();
+        void reserve(size_t count);
+        void resize(size_t count, uint64_t v = 0u);
+        void assign(size_t count, uint64_t v);
+        void assign(const uint64_t *first, const uint64_t *last);
+
+        friend bool operator==(const LimbVec &a, const LimbVec &b);
+
+    private:
+        size_t n;
+        size_t cap; // INLINE_LIMBS while the limbs live in inl
+        union
+        {
+            uint64_t inl[INLINE_LIMBS];
+            uint64_t *heap;
+        };
+
+        void grow(size_t need, bool keep);
+    };
+
     class BigInt
     {
     public:
@@ -25,7 +78,7 @@ namespace core
 
         friend BigInt operator+(BigInt lhs, const BigInt &rhs);
         friend BigInt operator-(BigInt lhs, const BigInt &rhs);
-        friend BigInt operator*(BigInt lhs, const BigInt &rhs);
+        friend BigInt operator*(const BigInt &lhs, const BigInt &rhs);
         friend BigInt operator/(BigInt lhs, const BigInt &rhs);
 
         friend bool operator==(const BigInt &a, const BigInt &b);
@@ -39,13 +92,116 @@ namespace core
         friend std::istream &operator>>(std::istream &is, BigInt &v);
 
         static BigInt from_string(const std::string &s);
+
+        // std::from_chars style: optional '-', then digits; {first, invalid_argument} and value
+        // untouched if there are none, otherwise ptr is one past the last digit
+        friend std::from_chars_result from_chars(const char *first, const char *last, BigInt &value);
         std::string to_string() const;
 
+        // exact length of the decimal form including the sign, what to_chars writes;
+        // to_chars follows std::to_chars: no terminator, {last, value_too_large} if it does not fit
+
+        size_t decimal_size() const;
+        std::to_chars_result to_chars(char *first, char *last) const;
+
+        BigInt sqr() const;
+
+        // dest = a * b; any of the three may be the same object, and dest keeps its buffer
+        // when the product fits and no Toom-Cook or NTT temporaries are involved
+
+        friend void mul_into(BigInt &dest, const BigInt &a, const BigInt &b);
+
+        // fused multiply-accumulate: *this += a * b and *this -= a * b; below the Karatsuba
+        // threshold the product goes through per-thread scratch, so only *this may reallocate.
+        // fma(a, b, c) is a * b + c in a single allocation on that path
+
+        BigInt &addmul(const BigInt &a, const BigInt &b);
+        BigInt &submul(const BigInt &a, const BigInt &b);
+        friend BigInt fma(const BigInt &a, const BigInt &b, const BigInt &c);
+
+        // SIMD kernels picked for this CPU: "avx512-ifma", "avx512", "avx2" or "scalar"
+
+        static const char *kernel_set();
+
+        // crossovers, in limbs, between the multiplication and division algorithms. The
+        // defaults are what bigint_tune measured if it has written bigint_tuned.hpp for this
+        // kernel set, otherwise the built-in constants. set_thresholds is for bigint_tune and
+        // tests: it throws invalid_argument on values the recursions cannot shrink from, and
+        // must not race with arithmetic on other threads
+
+        struct Thresholds
+        {
+            size_t karatsuba;
+            size_t karatsuba_sqr;
+            size_t toom3;
+            size_t toom4;
+            size_t ntt;
+            size_t burnikel_ziegler;
+        };
+        static Thresholds default_thresholds();
+        static const Thresholds &thresholds();
+        static void set_thresholds(const Thresholds &t);
+
+        // little-endian base 2^64 magnitude and sign, for layers built on raw limbs
+
+        std::span<const uint64_t> limbs() const;
+        bool is_negative() const;
+        static BigInt from_limbs(std::vector<uint64_t> limbs, bool negative = false);
+
+        // bit-level view of the magnitude; shifts keep the sign, so >>= truncates toward zero
+
+        bool is_zero() const;
+        bool is_odd() const;
+        size_t bit_length() const;
+        bool test_bit(size_t i) const;
+        BigInt &operator<<=(size_t bits);
+        BigInt &operator>>=(size_t bits);
+        friend BigInt operator<<(BigInt lhs, size_t bits);
+        friend BigInt operator>>(BigInt lhs, size_t bits);
+
+        // *this /= m truncating toward zero, returns |remainder|
+
+        uint32_t divmod_small(uint32_t m);
+
     private:
-        static const uint32_t BASE = 1000000000u;
-        static const uint32_t BASE_DIGS = 9u;
+        // limbs are binary, base 2^64; decimal only in from_string / to_string
+
+        static constexpr uint64_t DEC_BASE = 10000000000000000000ull;
+        static constexpr uint32_t DEC_DIGS = 19u;
+
+        // radix conversion switches to divide and conquer above this many limbs
+
+        static constexpr size_t DEC_DC_THRESHOLD = 30;
+
+        // Karatsuba
+
+        static const size_t KARATSUBA_THRESHOLD = 32; // at least 4, see kara_mul_n
+        static const size_t KARATSUBA_SQR_THRESHOLD = 48;
+
+        // Toom-Cook
+
+        static const size_t TOOM3_THRESHOLD = 200;
+        static const size_t TOOM4_THRESHOLD = 600;
 
-        std::vector<uint32_t> d;
+        // NTT
+
+        static const size_t NTT_THRESHOLD = 2500;
+
+        // with the AVX-512 IFMA base case schoolbook stays ahead of Karatsuba three times as
+        // long, which moves every later crossover out too; Toom-4 never wins before NTT there.
+        // default_thresholds() picks this set or the one above for the running CPU
+
+        static const size_t IFMA_KARATSUBA_THRESHOLD = 96;
+        static const size_t IFMA_KARATSUBA_SQR_THRESHOLD = 96;
+        static const size_t IFMA_TOOM3_THRESHOLD = 2500;
+        static const size_t IFMA_TOOM4_THRESHOLD = 64000;
+        static const size_t IFMA_NTT_THRESHOLD = 64000;
+
+        // Burnikel-Ziegler
+
+        static const size_t BURNIKEL_ZIEGLER_THRESHOLD = 64;
+
+        LimbVec d;
         bool neg;
 
         void trim();
@@ -55,8 +211,47 @@ namespace core
         static BigInt mul_abs(const BigInt &a, const BigInt &b);
         static void div_mod(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r);
 
-        static void add_inplace(std::vector<uint32_t> &x, const std::vector<uint32_t> &y);
-        static bool sub_inplace(std::vector<uint32_t> &x, const std::vector<uint32_t> &y);
+        static void add_inplace(LimbVec &x, const LimbVec &y);
+        static bool sub_inplace(LimbVec &x, const LimbVec &y);
+        static void mul_small_add(LimbVec &x, uint64_t m, uint64_t a);
+        static uint64_t div_small(LimbVec &x, uint64_t m);
+
+        static const BigInt &dec_power(size_t k);
+        static BigInt dec_pow10(size_t e);
+        static size_t dec_basecase(const uint64_t *x, size_t n, char *end);
+        static void dec_write(const BigInt &x, size_t k, char *out, size_t width);
+        static void from_string_basecase(const char *s, size_t len, LimbVec &x);
+        static BigInt from_string_rec(const char *s, size_t len);
+
+        static BigInt mul_karatsuba_abs(const BigInt &a, const BigInt &b);
+        static void split_at(const BigInt &a, size_t k, BigInt &low, BigInt &high);
+        static BigInt shift_base_abs(const BigInt &a, size_t k);
+        static size_t kara_scratch(size_t an, size_t bn);
+        static void kara_mul_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n, uint64_t *ws);
+        static void kara_mul(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn, uint64_t *ws);
+        static size_t kara_sqr_scratch(size_t n);
+        static void kara_sqr_n(uint64_t *r, const uint64_t *a, size_t n, uint64_t *ws);
+        static BigInt sqr_abs(const BigInt &a);
+
+        BigInt &mul_accumulate(const BigInt &a, const BigInt &b, bool subtract);
+
+        static BigInt mul_tiered_abs(const BigInt &a, const BigInt &b);
+        static BigInt mul_unbalanced_abs(const BigInt &a, const BigInt &b);
+        static BigInt mul_toom3_abs(const BigInt &a, const BigInt &b);
+        static BigInt mul_toom4_abs(const BigInt &a, const BigInt &b);
+        static BigInt mul_ntt_abs(const BigInt &a, const BigInt &b);
+        static BigInt mul_small(const BigInt &a, uint64_t m);
+        static void div_exact_small(BigInt &x, uint64_t m);
+        static BigInt mul_signed(const BigInt &a, const BigInt &b);
+
+        static void div_mod_schoolbook(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r);
+        static void div_mod_bz(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r);
+        static void div_2n1n(const BigInt &a, const BigInt &b, size_t n, BigInt &q, BigInt &r);
+        static void div_3n2n(const BigInt &a, const BigInt &b, size_t n, BigInt &q, BigInt &r);
     };
 
-} // namespace core
+    std::from_chars_result from_chars(const char *first, const char *last, BigInt &value);
+    BigInt fma(const BigInt &a, const BigInt &b, const BigInt &c);
+    void mul_into(BigInt &dest, const BigInt &a, const BigInt &b);
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+#include "barrett.hpp"
+#include "bigint.hpp"
+#include "montgomery.hpp"
+
+namespace core
+{
+
+    // g^e mod m for a fixed g and m and many exponents. Precomputes g^(v * 2^(w i)) for every
+    // w-bit window i of a max_bits exponent and every digit v, so pow() costs one multiply per
+    // non-zero window and no squarings. w is the largest width (up to 16) whose table fits in
+    // memory_budget bytes; if not even w = 1 fits, no table is built and window() is 0. Without a
+    // table, and for exponents wider than max_bits, pow() falls back to mod_exp.
+    // The object is immutable after construction and can be shared between threads.
+
+    class FixedBaseExp
+    {
+    public:
+        static const size_t DEFAULT_MEMORY_BUDGET = size_t(16) << 20;
+
+        FixedBaseExp(const BigInt &base, const BigInt &mod, size_t max_bits,
+                     size_t memory_budget = DEFAULT_MEMORY_BUDGET);
+
+        const BigInt &modulus() const;
+        size_t window() const;
+        size_t max_bits() const;
+
+        BigInt pow(const BigInt &exp) const;
+
+    private:
+        BigInt g;
+        BigInt m;
+        size_t w;
+        size_t bits;
+        std::variant<std::monostate, MontgomeryContext, BarrettContext> ctx;
+
+        // table[i * (2^w - 1) + v - 1] holds the residue of g^(v * 2^(w i))
+        std::vector<std::vector<uint64_t>> table;
+    };
+
+}
@@ -1,7 +1,33 @@
 #pragma once
+#include <span>
+#include <vector>
+
+#include "barrett.hpp"
 #include "bigint.hpp"
+#include "montgomery.hpp"
 
 namespace core
 {
     BigInt mod_exp(const BigInt &base, const BigInt &exp, const BigInt &mod);
+    BigInt mod_exp(const BigInt &base, const BigInt &exp, const MontgomeryContext &ctx);
+    BigInt mod_exp(const BigInt &base, const BigInt &exp, const BarrettContext &ctx);
+
+    // prod bases[i]^exps[i] mod m with one shared squaring chain (Straus / Shamir)
+    BigInt mod_multi_exp(std::span<const BigInt> bases, std::span<const BigInt> exps, const BigInt &mod);
+    BigInt mod_multi_exp(std::span<const BigInt> bases, std::span<const BigInt> exps, const MontgomeryContext &ctx);
+    BigInt mod_multi_exp(std::span<const BigInt> bases, std::span<const BigInt> exps, const BarrettContext &ctx);
+
+    // result[i] = bases[i]^exps[i] mod m (or mods[i]), in input order. One context is built per
+    // distinct modulus and shared read-only; worker threads pull items from a shared cursor.
+    // threads == 0 uses std::thread::hardware_concurrency(), which also caps larger counts.
+    std::vector<BigInt> mod_exp_batch(std::span<const BigInt> bases, std::span<const BigInt> exps,
+                                      const BigInt &mod, size_t threads = 0);
+    std::vector<BigInt> mod_exp_batch(std::span<const BigInt> bases, std::span<const BigInt> exps,
+                                      std::span<const BigInt> mods, size_t threads = 0);
+
+    // Montgomery ladder for secret exponents (odd modulus only). The ladder always runs
+    // over max(ctx.width(), exp limbs) * 64 bits with a branchless swap, so its timing
+    // does not depend on the exponent bits; base and modulus are treated as public.
+    BigInt mod_exp_ct(const BigInt &base, const BigInt &exp, const BigInt &mod);
+    BigInt mod_exp_ct(const BigInt &base, const BigInt &exp, const MontgomeryContext &ctx);
 }
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "bigint.hpp"
+
+namespace core
+{
+
+    // Montgomery arithmetic modulo an odd m > 1, R = 2^(64k) for a k-limb modulus.
+    // Residues are fixed-width vectors of k limbs holding a * R mod m.
+    // The context is immutable after construction and can be shared between threads.
+
+    class MontgomeryContext
+    {
+    public:
+        explicit MontgomeryContext(const BigInt &mod);
+
+        const BigInt &modulus() const;
+        size_t width() const;
+
+        void to_residue(const BigInt &a, std::vector<uint64_t> &out) const;
+        BigInt from_residue(const std::vector<uint64_t> &a) const;
+        void one(std::vector<uint64_t> &out) const;
+
+        // r = a * b * R^-1 mod m; r may alias a or b
+        void mul(std::vector<uint64_t> &r, const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) const;
+        void sqr(std::vector<uint64_t> &r, const std::vector<uint64_t> &a) const;
+
+        BigInt mul(const BigInt &a, const BigInt &b) const;
+
+    private:
+        BigInt m;
+        std::vector<uint64_t> n;
+        size_t k;
+        uint64_t n_inv;
+        std::vector<uint64_t> r1;
+        std::vector<uint64_t> r2;
+
+        void redc(std::vector<uint64_t> &r, uint64_t *t) const;
+    };
+
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "barrett.hpp"
+#include "residue_arith.hpp"
+
+namespace core
+{
+
+    // double-width product, then q1 * mu, per thread
+    static uint64_t *barrett_scratch(size_t need)
+    {
+        static thread_local std::vector<uint64_t> t;
+        if (t.size() < need)
+        {
+            t.resize(need);
+        }
+        return t.data();
+    }
+
+    BarrettContext::BarrettContext(const BigInt &mod) : m(mod), n(), k(0), mu()
+    {
+        if (m.is_negative() || m.limbs().empty() || m == BigInt(1))
+        {
+            throw std::invalid_argument("barrett modulus must be greater than one");
+        }
+        n.assign(m.limbs().begin(), m.limbs().end());
+        k = n.size();
+        std::vector<uint64_t> pow_b(2u * k + 1, 0u);
+        pow_b[2u * k] = 1u;
+        BigInt q = BigInt::from_limbs(pow_b) / m;
+        mu.assign(q.limbs().begin(), q.limbs().end());
+    }
+
+    const BigInt &BarrettContext::modulus() const
+    {
+        return m;
+    }
+
+    size_t BarrettContext::width() const
+    {
+        return k;
+    }
+
+    // r = t mod m for t < 2^(128k) held in t[0 .. 2k)
+    void BarrettContext::reduce(std::vector<uint64_t> &r, uint64_t *t) const
+    {
+        // q3 = floor(floor(t / B^(k-1)) * mu / B^(k+1)), at most two below floor(t / m)
+
+        const uint64_t *q1 = t + (k - 1);
+        size_t q1n = k + 1;
+        size_t mun = mu.size();
+        uint64_t *p = t + 2u * k;
+        std::fill(p, p + q1n + mun, 0u);
+        size_t i = 0;
+        while (i < q1n)
+        {
+            uint64_t carry = 0;
+            size_t j = 0;
+            while (j < mun)
+            {
+                u128 cur = static_cast<u128>(q1[i]) * mu[j] + p[i + j] + carry;
+                p[i + j] = static_cast<uint64_t>(cur);
+                carry = static_cast<uint64_t>(cur >> 64);
+                j += 1;
+            }
+            p[i + mun] = carry;
+            i += 1;
+        }
+        const uint64_t *q3 = p + (k + 1);
+        size_t q3n = q1n + mun - (k + 1);
+
+        // t mod B^(k+1) minus q3 * m mod B^(k+1), low k + 1 limbs only
+
+        uint64_t *s = p + q1n + mun;
+        std::fill(s, s + k + 1, 0u);
+        i = 0;
+        while (i < q3n && i < k + 1)
+        {
+            uint64_t carry = 0;
+            size_t j = 0;
+            while (j < k && i + j < k + 1)
+            {
+                u128 cur = static_cast<u128>(q3[i]) * n[j] + s[i + j] + carry;
+                s[i + j] = static_cast<uint64_t>(cur);
+                carry = static_cast<uint64_t>(cur >> 64);
+                j += 1;
+            }
+            if (i + j < k + 1)
+            {
+                s[i + j] = carry;
+            }
+            i += 1;
+        }
+        uint64_t borrow = 0;
+        i = 0;
+        while (i < k + 1)
+        {
+            uint64_t x = t[i];
+            uint64_t y = s[i];
+            s[i] = x - y - borrow;
+            borrow = (x < y || (x == y && borrow != 0)) ? 1u : 0u;
+            i += 1;
+        }
+
+        // at most two subtractions of m
+
+        while (true)
+        {
+            bool ge = s[k] != 0;
+            if (!ge)
+            {
+                ge = true;
+                size_t j = k;
+                while (j > 0)
+                {
+                    if (s[j - 1] != n[j - 1])
+                    {
+                        ge = s[j - 1] > n[j - 1];
+                        break;
+                    }
+                    j -= 1;
+                }
+            }
+            if (!ge)
+            {
+                break;
+            }
+            borrow = 0;
+            i = 0;
+            while (i < k + 1)
+            {
+                uint64_t x = s[i];
+                uint64_t y = i < k ? n[i] : 0u;
+                s[i] = x - y - borrow;
+                borrow = (x < y || (x == y && borrow != 0)) ? 1u : 0u;
+                i += 1;
+            }
+        }
+        r.assign(s, s + k);
+    }
+
+    void BarrettContext::mul(std::vector<uint64_t> &r, const std::vector<uint64_t> &a,
+                              const std::vector<uint64_t> &b) const
+    {
+        uint64_t *t = barrett_scratch(4u * k + mu.size() + 2u);
+        mul_wide(t, a.data(), b.data(), k);
+        reduce(r, t);
+    }
+
+    void BarrettContext::sqr(std::vector<uint64_t> &r, const std::vector<uint64_t> &a) const
+    {
+        uint64_t *t = barrett_scratch(4u * k + mu.size() + 2u);
+        sqr_wide(t, a.data(), k);
+        reduce(r, t);
+    }
+
+    void BarrettContext::to_residue(const BigInt &a, std::vector<uint64_t> &out) const
+    {
+        out = reduce_mod(a, m, k);
+    }
+
+    BigInt BarrettContext::from_residue(const std::vector<uint64_t> &a) const
+    {
+        return BigInt::from_limbs(a);
+    }
+
+    void BarrettContext::one(std::vector<uint64_t> &out) const
+    {
+        out.assign(k, 0u);
+        out[0] = 1u;
+    }
+
+    BigInt BarrettContext::mul(const BigInt &a, const BigInt &b) const
+    {
+        std::vector<uint64_t> x;
+        std::vector<uint64_t> y;
+        to_residue(a, x);
+        to_residue(b, y);
+        mul(x, x, y);
+        return from_residue(x);
+    }
+
+}
@@ -1,714 +1,2974 @@
 #include <algorithm>
+#include <bit>
 #include <cctype>
-#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 #include <limits>
 
 #include "bigint.hpp"
 
+#if __has_include("bigint_tuned.hpp")
+#include "bigint_tuned.hpp"
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define BIGINT_X86_SIMD 1
+#endif
+
 namespace core
 {
 
-    BigInt::BigInt() : d(), neg(false)
-    {
-    }
+    __extension__ typedef unsigned __int128 u128;
 
-    BigInt::BigInt(long long v) : d(), neg(false)
+    // limb kernels on (pointer, length) views, no allocation
+
+    // r = a + b and r = a - b over n limbs, r may alias a or b; return the carry or borrow.
+    // The vector versions resolve carries per block by lookahead: with G the lanes that
+    // overflow and P the lanes that would pass an incoming carry on, the carry into every
+    // lane is t | ((t + P) ^ t ^ P) for t = G << 1 | carry_in, one scalar add per block
+
+    typedef uint64_t (*LimbArith)(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n);
+
+    static uint64_t add_n_scalar(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
     {
-        if (v < 0)
+        uint64_t carry = 0;
+        size_t i = 0;
+        while (i < n)
         {
-            neg = true;
-            if (v == std::numeric_limits<long long>::min())
-            {
-                long long q = v / 10;
-                long long r = v % 10;
-                if (q < 0)
-                {
-                    q = -q;
-                }
-                if (r < 0)
-                {
-                    r = -r;
-                }
-                BigInt t(q);
-                t = t * BigInt(10) + BigInt(r);
-                *this = t;
-                neg = true;
-                return;
-            }
-            v = -v;
+            u128 s = static_cast<u128>(a[i]) + b[i] + carry;
+            r[i] = static_cast<uint64_t>(s);
+            carry = static_cast<uint64_t>(s >> 64);
+            i += 1;
         }
-        while (v > 0)
+        return carry;
+    }
+
+    static uint64_t sub_n_scalar(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+    {
+        uint64_t borrow = 0;
+        size_t i = 0;
+        while (i < n)
         {
-            uint32_t block = static_cast<uint32_t>(v % BASE);
-            d.push_back(block);
-            v /= BASE;
+            uint64_t x = a[i];
+            uint64_t y = b[i];
+            r[i] = x - y - borrow;
+            borrow = (x < y || (x == y && borrow != 0)) ? 1u : 0u;
+            i += 1;
         }
-        trim();
+        return borrow;
     }
 
-    BigInt::BigInt(const std::string &s)
+#ifdef BIGINT_X86_SIMD
+
+    // lanes of a four-bit mask as 0 / all-ones qwords
+    __attribute__((target("avx2"))) static __m256i lane_mask4(uint64_t m)
     {
-        *this = from_string(s);
+        const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+        __m256i v = _mm256_and_si256(_mm256_set1_epi64x(static_cast<long long>(m)), bits);
+        return _mm256_cmpeq_epi64(v, bits);
     }
 
-    BigInt BigInt::from_string(const std::string &s)
+    __attribute__((target("avx2"))) static uint64_t add_n_avx2(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
     {
-        BigInt r;
-        r.d.clear();
-        std::string t;
+        const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+        const __m256i ones = _mm256_set1_epi64x(-1);
+        uint64_t carry = 0;
         size_t i = 0;
-        while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])) != 0)
+        while (i + 4u <= n)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i s = _mm256_add_epi64(x, y);
+            __m256i g = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(s, sign));
+            __m256i p = _mm256_cmpeq_epi64(s, ones);
+            uint64_t G = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(g)));
+            uint64_t P = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(p)));
+            uint64_t t = (G << 1) | carry;
+            uint64_t c = t | ((t + P) ^ t ^ P);
+            carry = c >> 4;
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_sub_epi64(s, lane_mask4(c)));
+            i += 4u;
+        }
+        u128 s = carry;
+        while (i < n)
         {
+            s += static_cast<u128>(a[i]) + b[i];
+            r[i] = static_cast<uint64_t>(s);
+            s >>= 64;
             i += 1;
         }
-        bool is_neg = false;
-        if (i < s.size())
+        return static_cast<uint64_t>(s);
+    }
+
+    __attribute__((target("avx2"))) static uint64_t sub_n_avx2(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+    {
+        const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+        const __m256i zero = _mm256_setzero_si256();
+        uint64_t borrow = 0;
+        size_t i = 0;
+        while (i + 4u <= n)
         {
-            if (s[i] == '+')
-            {
-                i += 1;
-            }
-            else if (s[i] == '-')
-            {
-                is_neg = true;
-                i += 1;
-            }
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i s = _mm256_sub_epi64(x, y);
+            __m256i g = _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+            __m256i p = _mm256_cmpeq_epi64(s, zero);
+            uint64_t G = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(g)));
+            uint64_t P = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(p)));
+            uint64_t t = (G << 1) | borrow;
+            uint64_t c = t | ((t + P) ^ t ^ P);
+            borrow = c >> 4;
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_add_epi64(s, lane_mask4(c)));
+            i += 4u;
         }
-        while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])) != 0)
+        while (i < n)
         {
+            uint64_t x = a[i];
+            uint64_t y = b[i];
+            r[i] = x - y - borrow;
+            borrow = (x < y || (x == y && borrow != 0)) ? 1u : 0u;
             i += 1;
         }
-        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])) != 0)
+        return borrow;
+    }
+
+    __attribute__((target("avx512f"))) static uint64_t add_n_avx512(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+    {
+        const __m512i ones = _mm512_set1_epi64(-1);
+        uint64_t carry = 0;
+        size_t i = 0;
+        while (i + 8u <= n)
         {
-            t.push_back(s[i]);
-            i += 1;
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i s = _mm512_add_epi64(x, y);
+            uint64_t G = _mm512_cmplt_epu64_mask(s, x);
+            uint64_t P = _mm512_cmpeq_epu64_mask(s, ones);
+            uint64_t t = (G << 1) | carry;
+            uint64_t c = t | ((t + P) ^ t ^ P);
+            carry = c >> 8;
+            _mm512_storeu_si512(r + i, _mm512_mask_sub_epi64(s, static_cast<__mmask8>(c), s, ones));
+            i += 8u;
         }
-        size_t j = 0;
-        while (j < t.size() && t[j] == '0')
+        u128 s = carry;
+        while (i < n)
         {
-            j += 1;
+            s += static_cast<u128>(a[i]) + b[i];
+            r[i] = static_cast<uint64_t>(s);
+            s >>= 64;
+            i += 1;
         }
-        if (j == t.size())
+        return static_cast<uint64_t>(s);
+    }
+
+    __attribute__((target("avx512f"))) static uint64_t sub_n_avx512(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+    {
+        const __m512i ones = _mm512_set1_epi64(-1);
+        uint64_t borrow = 0;
+        size_t i = 0;
+        while (i + 8u <= n)
         {
-            r.neg = false;
-            r.d.clear();
-            return r;
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i s = _mm512_sub_epi64(x, y);
+            uint64_t G = _mm512_cmplt_epu64_mask(x, y);
+            uint64_t P = _mm512_cmpeq_epu64_mask(x, y);
+            uint64_t t = (G << 1) | borrow;
+            uint64_t c = t | ((t + P) ^ t ^ P);
+            borrow = c >> 8;
+            _mm512_storeu_si512(r + i, _mm512_mask_add_epi64(s, static_cast<__mmask8>(c), s, ones));
+            i += 8u;
         }
-        for (size_t p = t.size(); p > j;)
+        while (i < n)
         {
-            size_t start = p >= BASE_DIGS ? p - BASE_DIGS : 0;
-            if (start < j)
-            {
-                start = j;
-            }
-            size_t len = p - start;
-            uint32_t block = 0;
-            for (size_t k = start; k < start + len; ++k)
-            {
-                block = block * 10u + static_cast<uint32_t>(t[k] - '0');
-            }
-            r.d.push_back(block);
-            p = start;
+            uint64_t x = a[i];
+            uint64_t y = b[i];
+            r[i] = x - y - borrow;
+            borrow = (x < y || (x == y && borrow != 0)) ? 1u : 0u;
+            i += 1;
         }
-        r.neg = is_neg;
-        r.trim();
-        return r;
+        return borrow;
     }
 
-    BigInt::BigInt(const BigInt &other) : d(other.d), neg(other.neg)
+#endif
+
+    // chosen once from cpuid; the scalar loop is also used below one vector block.
+    // BIGINT_SIMD=avx2 or BIGINT_SIMD=none in the environment caps the choice, so every
+    // kernel set, and the thresholds that go with it, can be exercised on one machine
+
+    struct LimbKernels
+    {
+        LimbArith add;
+        LimbArith sub;
+        bool ifma;
+        const char *name;
+    };
+
+    static LimbKernels pick_limb_kernels()
     {
+#ifdef BIGINT_X86_SIMD
+        const char *env = std::getenv("BIGINT_SIMD");
+        std::string_view cap = env != nullptr ? env : "";
+        __builtin_cpu_init();
+        if (cap != "none" && cap != "avx2" && __builtin_cpu_supports("avx512f"))
+        {
+            bool ifma = __builtin_cpu_supports("avx512ifma") != 0;
+            return {add_n_avx512, sub_n_avx512, ifma, ifma ? "avx512-ifma" : "avx512"};
+        }
+        if (cap != "none" && __builtin_cpu_supports("avx2"))
+        {
+            return {add_n_avx2, sub_n_avx2, false, "avx2"};
+        }
+#endif
+        return {add_n_scalar, sub_n_scalar, false, "scalar"};
     }
 
-    BigInt::BigInt(BigInt &&other) noexcept : d(std::move(other.d)), neg(other.neg)
+    static const LimbKernels &limb_kernels()
     {
-        other.neg = false;
+        static const LimbKernels k = pick_limb_kernels();
+        return k;
     }
 
-    BigInt &BigInt::operator=(const BigInt &other)
+    static uint64_t add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
     {
-        if (this != &other)
+        if (n < 8u)
         {
-            d = other.d;
-            neg = other.neg;
+            return add_n_scalar(r, a, b, n);
         }
-        return *this;
+        return limb_kernels().add(r, a, b, n);
     }
 
-    BigInt &BigInt::operator=(BigInt &&other) noexcept
+    static uint64_t sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
     {
-        if (this != &other)
+        if (n < 8u)
         {
-            d = std::move(other.d);
-            neg = other.neg;
-            other.neg = false;
+            return sub_n_scalar(r, a, b, n);
         }
-        return *this;
+        return limb_kernels().sub(r, a, b, n);
     }
 
-    void BigInt::trim()
+    // r = a + b, an >= bn, r has an limbs and may alias a; returns the carry
+    static uint64_t limb_add(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
     {
-        while (!d.empty() && d.back() == 0u)
+        uint64_t carry = add_n(r, a, b, bn);
+        size_t i = bn;
+        while (i < an)
         {
-            d.pop_back();
+            uint64_t s = a[i] + carry;
+            carry = (s < carry) ? 1u : 0u;
+            r[i] = s;
+            i += 1;
         }
-        if (d.empty())
+        return carry;
+    }
+
+    // r += b, rn >= bn; returns the carry out of r[rn - 1]
+    static uint64_t limb_add_in(uint64_t *r, size_t rn, const uint64_t *b, size_t bn)
+    {
+        uint64_t carry = add_n(r, r, b, bn);
+        size_t i = bn;
+        while (carry != 0 && i < rn)
         {
-            neg = false;
+            r[i] += 1u;
+            carry = (r[i] == 0u) ? 1u : 0u;
+            i += 1;
         }
+        return carry;
     }
 
-    int BigInt::cmp_abs(const BigInt &a, const BigInt &b)
+    // r = a - b, an >= bn, r has an limbs and may alias a or b; returns the borrow
+    static uint64_t limb_sub(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
     {
-        if (a.d.size() > b.d.size())
+        uint64_t borrow = sub_n(r, a, b, bn);
+        size_t i = bn;
+        while (i < an)
         {
-            return 1;
+            uint64_t x = a[i];
+            r[i] = x - borrow;
+            borrow = (x < borrow) ? 1u : 0u;
+            i += 1;
         }
-        if (a.d.size() < b.d.size())
+        return borrow;
+    }
+
+    // r -= b, rn >= bn; returns the borrow out of r[rn - 1]
+    static uint64_t limb_sub_in(uint64_t *r, size_t rn, const uint64_t *b, size_t bn)
+    {
+        uint64_t borrow = sub_n(r, r, b, bn);
+        size_t i = bn;
+        while (borrow != 0 && i < rn)
         {
-            return -1;
+            borrow = (r[i] == 0u) ? 1u : 0u;
+            r[i] -= 1u;
+            i += 1;
         }
-        size_t n = a.d.size();
-        while (n > 0)
+        return borrow;
+    }
+
+    static void limb_mul_scalar(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
+    {
+        std::fill(r, r + an + bn, 0u);
+        size_t i = 0;
+        while (i < an)
         {
-            uint32_t x = a.d[n - 1];
-            uint32_t y = b.d[n - 1];
-            if (x > y)
-            {
-                return 1;
-            }
-            if (x < y)
+            uint64_t carry = 0;
+            uint64_t xi = a[i];
+            size_t j = 0;
+            while (j < bn)
             {
-                return -1;
+                u128 cur = static_cast<u128>(xi) * b[j] + r[i + j] + carry;
+                r[i + j] = static_cast<uint64_t>(cur);
+                carry = static_cast<uint64_t>(cur >> 64);
+                j += 1;
             }
-            n -= 1;
+            r[i + bn] = carry;
+            i += 1;
         }
-        return 0;
     }
 
-    BigInt BigInt::add_abs(const BigInt &a, const BigInt &b)
+    // r = a^2, r has 2n limbs; every cross product a[i] * a[j], i < j, is computed once
+    static void limb_sqr_scalar(uint64_t *r, const uint64_t *a, size_t n)
     {
-        BigInt r;
-        size_t n = a.d.size();
-        size_t m = b.d.size();
-        size_t sz = n > m ? n : m;
-        r.d.resize(sz);
-        uint64_t carry = 0;
+        std::fill(r, r + 2u * n, 0u);
         size_t i = 0;
-        while (i < sz)
+        while (i < n)
         {
-            uint64_t x = 0;
-            uint64_t y = 0;
-            if (i < n)
-            {
-                x = a.d[i];
-            }
-            if (i < m)
+            uint64_t carry = 0;
+            uint64_t xi = a[i];
+            size_t j = i + 1;
+            while (j < n)
             {
-                y = b.d[i];
+                u128 cur = static_cast<u128>(xi) * a[j] + r[i + j] + carry;
+                r[i + j] = static_cast<uint64_t>(cur);
+                carry = static_cast<uint64_t>(cur >> 64);
+                j += 1;
             }
-            uint64_t s = x + y + carry;
-            r.d[i] = static_cast<uint32_t>(s % BASE);
-            carry = s / BASE;
+            r[i + n] = carry;
             i += 1;
         }
-        if (carry > 0)
+
+        // double the cross products, then add the diagonal squares
+
+        uint64_t top = 0;
+        i = 0;
+        while (i < 2u * n)
         {
-            r.d.push_back(static_cast<uint32_t>(carry));
+            uint64_t x = r[i];
+            r[i] = (x << 1) | top;
+            top = x >> 63;
+            i += 1;
+        }
+        uint64_t carry = 0;
+        i = 0;
+        while (i < n)
+        {
+            u128 sq = static_cast<u128>(a[i]) * a[i];
+            u128 s = static_cast<u128>(r[2u * i]) + static_cast<uint64_t>(sq) + carry;
+            r[2u * i] = static_cast<uint64_t>(s);
+            s = static_cast<u128>(r[2u * i + 1u]) + static_cast<uint64_t>(sq >> 64) + static_cast<uint64_t>(s >> 64);
+            r[2u * i + 1u] = static_cast<uint64_t>(s);
+            carry = static_cast<uint64_t>(s >> 64);
+            i += 1;
         }
-        r.neg = false;
-        r.trim();
-        return r;
     }
 
-    BigInt BigInt::sub_abs(const BigInt &a, const BigInt &b)
+#ifdef BIGINT_X86_SIMD
+
+    // AVX-512 IFMA: operands recoded to 52-bit digits, then product scanning eight columns
+    // at a time, each column collecting the low and high halves of its 52 x 52 products.
+    // With at most IFMA_MAX_LIMBS limbs a side a column sum stays below 2^60, so carries
+    // wait for the single pass that packs the columns back into 64-bit limbs
+
+    static const size_t IFMA_MUL_MIN = 16;
+    static const size_t IFMA_SQR_MIN = 24;
+    static const size_t IFMA_MAX_LIMBS = 96;
+    static const size_t IFMA_MAX_DIGITS = (64u * IFMA_MAX_LIMBS + 51u) / 52u;
+    static const uint64_t DIGIT52_MASK = (uint64_t(1) << 52) - 1u;
+
+    static size_t to_digits52(uint64_t *out, const uint64_t *a, size_t n)
     {
-        BigInt r;
-        r.d.resize(a.d.size());
-        int64_t carry = 0;
-        size_t i = 0;
-        while (i < a.d.size())
+        size_t digits = (64u * n + 51u) / 52u;
+        size_t t = 0;
+        while (t < digits)
         {
-            int64_t x = a.d[i];
-            int64_t y = 0;
-            if (i < b.d.size())
+            size_t bit = 52u * t;
+            size_t l = bit / 64u;
+            unsigned sh = static_cast<unsigned>(bit % 64u);
+            uint64_t v = a[l] >> sh;
+            if (sh > 12u && l + 1u < n)
             {
-                y = b.d[i];
+                v |= a[l + 1u] << (64u - sh);
             }
-            int64_t s = x - y - carry;
-            if (s < 0)
+            out[t] = v & DIGIT52_MASK;
+            t += 1;
+        }
+        return digits;
+    }
+
+    // cols[0 .. xn + yn] += column sums of x * y; x has 8 zero digits on either side
+    __attribute__((target("avx512f,avx512ifma"))) static void ifma_columns(uint64_t *cols, const uint64_t *x, size_t xn, const uint64_t *y, size_t yn)
+    {
+        size_t nc = xn + yn;
+        size_t c = 0;
+        while (c < nc)
+        {
+            // lane l is column c + l, fed by x[c + l - i] * y[i]
+
+            __m512i lo0 = _mm512_setzero_si512();
+            __m512i lo1 = lo0;
+            __m512i hi0 = lo0;
+            __m512i hi1 = lo0;
+            size_t i = c + 1u > xn ? c + 1u - xn : 0u;
+            size_t end = std::min(yn, c + 8u);
+            while (i + 1u < end)
             {
-                s += BASE;
-                carry = 1;
+                __m512i x0 = _mm512_loadu_si512(x + c - i);
+                __m512i x1 = _mm512_loadu_si512(x + c - i - 1u);
+                __m512i y0 = _mm512_set1_epi64(static_cast<long long>(y[i]));
+                __m512i y1 = _mm512_set1_epi64(static_cast<long long>(y[i + 1u]));
+                lo0 = _mm512_madd52lo_epu64(lo0, x0, y0);
+                hi0 = _mm512_madd52hi_epu64(hi0, x0, y0);
+                lo1 = _mm512_madd52lo_epu64(lo1, x1, y1);
+                hi1 = _mm512_madd52hi_epu64(hi1, x1, y1);
+                i += 2u;
             }
-            else
+            if (i < end)
             {
-                carry = 0;
+                __m512i x0 = _mm512_loadu_si512(x + c - i);
+                __m512i y0 = _mm512_set1_epi64(static_cast<long long>(y[i]));
+                lo0 = _mm512_madd52lo_epu64(lo0, x0, y0);
+                hi0 = _mm512_madd52hi_epu64(hi0, x0, y0);
             }
-            r.d[i] = static_cast<uint32_t>(s);
-            i += 1;
+            __m512i lo = _mm512_add_epi64(_mm512_loadu_si512(cols + c), _mm512_add_epi64(lo0, lo1));
+            _mm512_storeu_si512(cols + c, lo);
+            __m512i hi = _mm512_add_epi64(_mm512_loadu_si512(cols + c + 1u), _mm512_add_epi64(hi0, hi1));
+            _mm512_storeu_si512(cols + c + 1u, hi);
+            c += 8u;
         }
-        r.neg = false;
-        r.trim();
-        return r;
     }
 
-    BigInt BigInt::mul_abs(const BigInt &a, const BigInt &b)
+    // r = a * b, an and bn at most IFMA_MAX_LIMBS, r has an + bn limbs
+    static void limb_mul_ifma(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
     {
-        BigInt r;
-        if (a.d.empty() || b.d.empty())
-        {
-            return r;
-        }
-        r.d.assign(a.d.size() + b.d.size(), 0u);
-        size_t i = 0;
-        while (i < a.d.size())
+        uint64_t xbuf[IFMA_MAX_DIGITS + 16u];
+        uint64_t y[IFMA_MAX_DIGITS];
+        uint64_t cols[2u * IFMA_MAX_DIGITS + 16u];
+
+        uint64_t *x = xbuf + 8;
+        std::fill(xbuf, x, 0u);
+        size_t xn = to_digits52(x, a, an);
+        std::fill(x + xn, x + xn + 8u, 0u);
+        size_t yn = to_digits52(y, b, bn);
+        std::fill(cols, cols + xn + yn + 16u, 0u);
+        ifma_columns(cols, x, xn, y, yn);
+
+        size_t rn = an + bn;
+        size_t w = 0;
+        size_t t = 0;
+        u128 acc = 0;
+        unsigned have = 0;
+        uint64_t carry = 0;
+        while (w < rn)
         {
-            uint64_t carry = 0;
-            uint64_t xi = a.d[i];
-            size_t j = 0;
-            while (j < b.d.size())
-            {
-                uint64_t cur = r.d[i + j] + xi * static_cast<uint64_t>(b.d[j]) + carry;
-                r.d[i + j] = static_cast<uint32_t>(cur % BASE);
-                carry = cur / BASE;
-                j += 1;
-            }
-            size_t pos = i + b.d.size();
-            while (carry > 0)
+            uint64_t v = cols[t] + carry;
+            carry = v >> 52;
+            acc |= static_cast<u128>(v & DIGIT52_MASK) << have;
+            have += 52u;
+            if (have >= 64u)
             {
-                uint64_t cur = r.d[pos] + carry;
-                r.d[pos] = static_cast<uint32_t>(cur % BASE);
-                carry = cur / BASE;
-                pos += 1;
+                r[w] = static_cast<uint64_t>(acc);
+                acc >>= 64;
+                have -= 64u;
+                w += 1;
             }
-            i += 1;
+            t += 1;
         }
-        r.neg = false;
-        r.trim();
-        return r;
     }
 
-    bool BigInt::sub_inplace(std::vector<uint32_t> &x, const std::vector<uint32_t> &y)
+#endif
+
+    // r = a * b, r has an + bn limbs and does not alias a or b
+    static void limb_mul_basecase(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn)
     {
-        if (x.size() < y.size())
+#ifdef BIGINT_X86_SIMD
+        if (an < bn)
         {
-            return false;
+            std::swap(a, b);
+            std::swap(an, bn);
         }
-        int64_t carry = 0;
-        size_t i = 0;
-        while (i < x.size())
+        if (bn >= IFMA_MUL_MIN && bn <= IFMA_MAX_LIMBS && limb_kernels().ifma)
         {
-            int64_t a = x[i];
-            int64_t b = 0;
-            if (i < y.size())
-            {
-                b = y[i];
-            }
-            int64_t s = a - b - carry;
-            if (s < 0)
+            if (an <= IFMA_MAX_LIMBS)
             {
-                s += BASE;
-                carry = 1;
+                limb_mul_ifma(r, a, an, b, bn);
+                return;
             }
-            else
+
+            // longer side in IFMA_MAX_LIMBS pieces
+
+            uint64_t t[2u * IFMA_MAX_LIMBS];
+            std::fill(r, r + an + bn, 0u);
+            size_t off = 0;
+            while (off < an)
             {
-                carry = 0;
+                size_t len = std::min(IFMA_MAX_LIMBS, an - off);
+                limb_mul_ifma(t, a + off, len, b, bn);
+                limb_add_in(r + off, an + bn - off, t, len + bn);
+                off += len;
             }
-            x[i] = static_cast<uint32_t>(s);
-            i += 1;
+            return;
         }
-        if (carry != 0)
+#endif
+        limb_mul_scalar(r, a, an, b, bn);
+    }
+
+    static void limb_sqr_basecase(uint64_t *r, const uint64_t *a, size_t n)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (n >= IFMA_SQR_MIN && n <= IFMA_MAX_LIMBS && limb_kernels().ifma)
         {
-            return false;
+            limb_mul_ifma(r, a, n, a, n);
+            return;
         }
-        while (!x.empty() && x.back() == 0u)
+#endif
+        limb_sqr_scalar(r, a, n);
+    }
+
+    // one arena per thread, grown on demand and reused by every later multiply
+    static uint64_t *scratch_arena(size_t need)
+    {
+        static thread_local std::vector<uint64_t> arena;
+        if (arena.size() < need)
         {
-            x.pop_back();
+            arena.resize(need);
         }
-        return true;
+        return arena.data();
     }
 
-    void BigInt::div_mod(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
+    // LimbVec
+
+    LimbVec::LimbVec() : n(0), cap(INLINE_LIMBS), inl()
     {
-        if (b.d.empty())
+    }
+
+    LimbVec::LimbVec(const LimbVec &other) : n(0), cap(INLINE_LIMBS), inl()
+    {
+        assign(other.begin(), other.end());
+    }
+
+    LimbVec::LimbVec(LimbVec &&other) noexcept : n(other.n), cap(other.cap), inl()
+    {
+        if (other.cap > INLINE_LIMBS)
         {
-            throw std::domain_error("division by zero");
+            heap = other.heap;
+            other.cap = INLINE_LIMBS;
         }
-        if (a.d.empty())
+        else
         {
-            q.d.clear();
-            q.neg = false;
-            r.d.clear();
-            r.neg = false;
-            return;
+            std::copy(other.inl, other.inl + other.n, inl);
         }
-        int cmp = cmp_abs(a, b);
-        if (cmp < 0)
+        other.n = 0;
+    }
+
+    LimbVec &LimbVec::operator=(const LimbVec &other)
+    {
+        if (this != &other)
         {
-            q.d.clear();
-            q.neg = false;
-            r = a;
-            r.neg = false;
-            return;
+            assign(other.begin(), other.end());
         }
-        if (cmp == 0)
+        return *this;
+    }
+
+    LimbVec &LimbVec::operator=(LimbVec &&other) noexcept
+    {
+        if (this == &other)
         {
-            q.d.assign(1, 1u);
-            q.neg = false;
-            r.d.clear();
+            return *this;
+        }
+        if (other.cap > INLINE_LIMBS)
+        {
+            if (cap > INLINE_LIMBS)
+            {
+                delete[] heap;
+            }
+            heap = other.heap;
+            cap = other.cap;
+            other.cap = INLINE_LIMBS;
+        }
+        else
+        {
+            // inline source: copy into whatever buffer we already own
+
+            std::copy(other.inl, other.inl + other.n, data());
+        }
+        n = other.n;
+        other.n = 0;
+        return *this;
+    }
+
+    LimbVec::~LimbVec()
+    {
+        if (cap > INLINE_LIMBS)
+        {
+            delete[] heap;
+        }
+    }
+
+    size_t LimbVec::size() const
+    {
+        return n;
+    }
+
+    bool LimbVec::empty() const
+    {
+        return n == 0;
+    }
+
+    size_t LimbVec::capacity() const
+    {
+        return cap;
+    }
+
+    uint64_t *LimbVec::data()
+    {
+        return cap > INLINE_LIMBS ? heap : inl;
+    }
+
+    const uint64_t *LimbVec::data() const
+    {
+        return cap > INLINE_LIMBS ? heap : inl;
+    }
+
+    uint64_t *LimbVec::begin()
+    {
+        return data();
+    }
+
+    uint64_t *LimbVec::end()
+    {
+        return data() + n;
+    }
+
+    const uint64_t *LimbVec::begin() const
+    {
+        return data();
+    }
+
+    const uint64_t *LimbVec::end() const
+    {
+        return data() + n;
+    }
+
+    uint64_t &LimbVec::operator[](size_t i)
+    {
+        return data()[i];
+    }
+
+    const uint64_t &LimbVec::operator[](size_t i) const
+    {
+        return data()[i];
+    }
+
+    uint64_t &LimbVec::back()
+    {
+        return data()[n - 1];
+    }
+
+    const uint64_t &LimbVec::back() const
+    {
+        return data()[n - 1];
+    }
+
+    // capacity >= need, at least doubling; keep says whether the current limbs must survive
+    void LimbVec::grow(size_t need, bool keep)
+    {
+        size_t next = std::max(need, 2u * cap);
+        uint64_t *fresh = new uint64_t[next];
+        if (keep)
+        {
+            std::copy(data(), data() + n, fresh);
+        }
+        if (cap > INLINE_LIMBS)
+        {
+            delete[] heap;
+        }
+        heap = fresh;
+        cap = next;
+    }
+
+    void LimbVec::push_back(uint64_t v)
+    {
+        if (n == cap)
+        {
+            grow(n + 1, true);
+        }
+        data()[n] = v;
+        n += 1;
+    }
+
+    void LimbVec::pop_back()
+    {
+        n -= 1;
+    }
+
+    void LimbVec::clear()
+    {
+        n = 0;
+    }
+
+    void LimbVec::reserve(size_t count)
+    {
+        if (count > cap)
+        {
+            grow(count, true);
+        }
+    }
+
+    void LimbVec::resize(size_t count, uint64_t v)
+    {
+        if (count > cap)
+        {
+            grow(count, true);
+        }
+        if (count > n)
+        {
+            std::fill(data() + n, data() + count, v);
+        }
+        n = count;
+    }
+
+    void LimbVec::assign(size_t count, uint64_t v)
+    {
+        if (count > cap)
+        {
+            grow(count, false);
+        }
+        std::fill(data(), data() + count, v);
+        n = count;
+    }
+
+    // [first, last) may point into this vector
+    void LimbVec::assign(const uint64_t *first, const uint64_t *last)
+    {
+        size_t count = static_cast<size_t>(last - first);
+        if (count > cap)
+        {
+            size_t next = std::max(count, 2u * cap);
+            uint64_t *fresh = new uint64_t[next];
+            std::copy(first, last, fresh);
+            if (cap > INLINE_LIMBS)
+            {
+                delete[] heap;
+            }
+            heap = fresh;
+            cap = next;
+        }
+        else if (count != 0)
+        {
+            std::memmove(data(), first, count * sizeof(uint64_t));
+        }
+        n = count;
+    }
+
+    bool operator==(const LimbVec &a, const LimbVec &b)
+    {
+        return a.n == b.n && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+    BigInt::BigInt() : d(), neg(false)
+    {
+    }
+
+    BigInt::BigInt(long long v) : d(), neg(false)
+    {
+        uint64_t u = static_cast<uint64_t>(v);
+        if (v < 0)
+        {
+            neg = true;
+            u = 0u - u;
+        }
+        if (u != 0u)
+        {
+            d.push_back(u);
+        }
+    }
+
+    BigInt::BigInt(const std::string &s)
+    {
+        *this = from_string(s);
+    }
+
+    // 10^(DEC_DIGS * 2^k), cached per thread; a deque keeps earlier references valid as it grows
+    const BigInt &BigInt::dec_power(size_t k)
+    {
+        static thread_local std::deque<BigInt> pows;
+        if (pows.empty())
+        {
+            BigInt p;
+            p.d.push_back(DEC_BASE);
+            pows.push_back(std::move(p));
+        }
+        while (pows.size() <= k)
+        {
+            pows.push_back(pows.back().sqr());
+        }
+        return pows[k];
+    }
+
+    static const uint64_t POW10[20] = {1ull,
+                                       10ull,
+                                       100ull,
+                                       1000ull,
+                                       10000ull,
+                                       100000ull,
+                                       1000000ull,
+                                       10000000ull,
+                                       100000000ull,
+                                       1000000000ull,
+                                       10000000000ull,
+                                       100000000000ull,
+                                       1000000000000ull,
+                                       10000000000000ull,
+                                       100000000000000ull,
+                                       1000000000000000ull,
+                                       10000000000000000ull,
+                                       100000000000000000ull,
+                                       1000000000000000000ull,
+                                       10000000000000000000ull};
+
+    static uint64_t load8(const char *p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            v = __builtin_bswap64(v);
+        }
+        return v;
+    }
+
+    // SWAR: all eight bytes in '0' .. '9' iff every high nibble is 3 both before and after adding 6
+    static bool all_digits8(const char *p)
+    {
+        uint64_t v = load8(p);
+        uint64_t hi = v & 0xf0f0f0f0f0f0f0f0ull;
+        uint64_t hi6 = (v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull;
+        return (hi | (hi6 >> 4)) == 0x3333333333333333ull;
+    }
+
+    // SWAR: eight digits to their value, merging pairs, then quads, then the two halves;
+    // the first character sits in the low byte
+    static uint64_t parse8(const char *p)
+    {
+        uint64_t v = load8(p) - 0x3030303030303030ull;
+        v = (v * 10u + (v >> 8)) & 0x00ff00ff00ff00ffull;
+        v = (v * 100u + (v >> 16)) & 0x0000ffff0000ffffull;
+        v = (v * 10000u + (v >> 32)) & 0x00000000ffffffffull;
+        return v;
+    }
+
+    // value of n <= 19 digits: the n % 8 leading ones singly, the rest eight at a time
+    static uint64_t parse_digits(const char *s, size_t n)
+    {
+        uint64_t v = 0;
+        size_t i = 0;
+        while (i < n % 8u)
+        {
+            v = v * 10u + static_cast<uint64_t>(s[i] - '0');
+            i += 1;
+        }
+        while (i < n)
+        {
+            v = v * 100000000u + parse8(s + i);
+            i += 8;
+        }
+        return v;
+    }
+
+    // end of the run of decimal digits starting at p
+    static const char *scan_digits(const char *p, const char *last)
+    {
+        while (last - p >= 8 && all_digits8(p))
+        {
+            p += 8;
+        }
+        while (p < last && static_cast<unsigned char>(*p - '0') < 10u)
+        {
+            p += 1;
+        }
+        return p;
+    }
+
+    // x = digits s[0 .. len) for an empty x, reusing its capacity
+    void BigInt::from_string_basecase(const char *s, size_t len, LimbVec &x)
+    {
+        // x = x * 10^len + chunk, DEC_DIGS decimal digits at a time
+
+        size_t first = len % DEC_DIGS;
+        if (first == 0)
+        {
+            first = DEC_DIGS;
+        }
+        size_t p = 0;
+        size_t n = first;
+        while (p < len)
+        {
+            mul_small_add(x, POW10[n], parse_digits(s + p, n));
+            p += n;
+            n = DEC_DIGS;
+        }
+        while (!x.empty() && x.back() == 0u)
+        {
+            x.pop_back();
+        }
+    }
+
+    // digits s[0 .. len) as high * 10^low + low, where low = DEC_DIGS * 2^k is the largest such
+    // power below len, so both halves reuse the cached dec_power(k)
+    BigInt BigInt::from_string_rec(const char *s, size_t len)
+    {
+        if (len <= DEC_DC_THRESHOLD * DEC_DIGS)
+        {
+            BigInt r;
+            from_string_basecase(s, len, r.d);
+            return r;
+        }
+        size_t k = 0;
+        while ((static_cast<size_t>(DEC_DIGS) << (k + 1)) < len)
+        {
+            k += 1;
+        }
+        size_t low = static_cast<size_t>(DEC_DIGS) << k;
+        BigInt r = from_string_rec(s, len - low) * dec_power(k);
+        r += from_string_rec(s + len - low, low);
+        return r;
+    }
+
+    BigInt BigInt::from_string(const std::string &s)
+    {
+        size_t i = 0;
+        while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])) != 0)
+        {
+            i += 1;
+        }
+        bool is_neg = false;
+        if (i < s.size())
+        {
+            if (s[i] == '+')
+            {
+                i += 1;
+            }
+            else if (s[i] == '-')
+            {
+                is_neg = true;
+                i += 1;
+            }
+        }
+        while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])) != 0)
+        {
+            i += 1;
+        }
+        while (i < s.size() && s[i] == '0')
+        {
+            i += 1;
+        }
+        size_t j = static_cast<size_t>(scan_digits(s.data() + i, s.data() + s.size()) - s.data());
+        BigInt r = from_string_rec(s.data() + i, j - i);
+        r.neg = is_neg;
+        r.trim();
+        return r;
+    }
+
+    std::from_chars_result from_chars(const char *first, const char *last, BigInt &value)
+    {
+        const char *p = first;
+        bool is_neg = false;
+        if (p < last && *p == '-')
+        {
+            is_neg = true;
+            p += 1;
+        }
+        const char *digits = p;
+        p = scan_digits(p, last);
+        if (p == digits)
+        {
+            return {first, std::errc::invalid_argument};
+        }
+        while (digits < p && *digits == '0')
+        {
+            digits += 1;
+        }
+        size_t len = static_cast<size_t>(p - digits);
+        if (len <= BigInt::DEC_DC_THRESHOLD * BigInt::DEC_DIGS)
+        {
+            value.d.clear();
+            BigInt::from_string_basecase(digits, len, value.d);
+        }
+        else
+        {
+            value = BigInt::from_string_rec(digits, len);
+        }
+        value.neg = is_neg;
+        value.trim();
+        return {p, std::errc()};
+    }
+
+    static const char DEC_PAIRS[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                    "8081828384858687888990919293949596979899";
+
+    // floor(log10(2) * 2^64)
+    static const uint64_t LOG10_2_FIXED = 0x4d104d427de7fbccull;
+
+    // n <= 9 low decimal digits of v ending at end, two at a time from the pair table
+    static void put_digits(char *end, uint32_t v, size_t n)
+    {
+        while (n >= 2)
+        {
+            end -= 2;
+            std::memcpy(end, DEC_PAIRS + 2u * (v % 100u), 2);
+            v /= 100u;
+            n -= 2;
+        }
+        if (n == 1)
+        {
+            end[-1] = static_cast<char>('0' + v % 10u);
+        }
+    }
+
+    // n <= 19 low decimal digits of c ending at end, as 9-digit pieces
+    static void put_chunk(char *end, uint64_t c, size_t n)
+    {
+        while (n > 9)
+        {
+            put_digits(end, static_cast<uint32_t>(c % 1000000000u), 9);
+            c /= 1000000000u;
+            end -= 9;
+            n -= 9;
+        }
+        put_digits(end, static_cast<uint32_t>(c), n);
+    }
+
+    static size_t u64_digits(uint64_t c)
+    {
+        size_t n = 1;
+        while (c >= 10u)
+        {
+            c /= 10u;
+            n += 1;
+        }
+        return n;
+    }
+
+    // digits of 2^(bits - 1) from fixed-point log10(2), possibly one short; a value of that
+    // bit length has between this and this + 2 digits
+    static size_t dec_digits_lower(size_t bits)
+    {
+        return static_cast<size_t>((static_cast<u128>(bits - 1u) * LOG10_2_FIXED) >> 64) + 1u;
+    }
+
+    // 10^e from the cached 10^(DEC_DIGS * 2^k) and one small power
+    BigInt BigInt::dec_pow10(size_t e)
+    {
+        uint64_t small = 1;
+        for (size_t i = 0; i < e % DEC_DIGS; ++i)
+        {
+            small *= 10u;
+        }
+        BigInt r;
+        r.d.push_back(small);
+        size_t q = e / DEC_DIGS;
+        size_t k = 0;
+        while (q != 0)
+        {
+            if ((q & 1u) != 0)
+            {
+                r *= dec_power(k);
+            }
+            q >>= 1;
+            k += 1;
+        }
+        return r;
+    }
+
+    // writes all digits of x[0 .. n), n <= DEC_DC_THRESHOLD, right to left ending at end;
+    // returns how many (0 for n == 0)
+    size_t BigInt::dec_basecase(const uint64_t *x, size_t n, char *end)
+    {
+        uint64_t t[DEC_DC_THRESHOLD];
+        std::copy(x, x + n, t);
+        char *p = end;
+        while (n > 0)
+        {
+            uint64_t rem = 0;
+            size_t i = n;
+            while (i > 0)
+            {
+                u128 cur = (static_cast<u128>(rem) << 64) | t[i - 1];
+                t[i - 1] = static_cast<uint64_t>(cur / DEC_BASE);
+                rem = static_cast<uint64_t>(cur % DEC_BASE);
+                i -= 1;
+            }
+            while (n > 0 && t[n - 1] == 0u)
+            {
+                n -= 1;
+            }
+            size_t len = n > 0 ? static_cast<size_t>(DEC_DIGS) : u64_digits(rem);
+            put_chunk(p, rem, len);
+            p -= len;
+        }
+        return static_cast<size_t>(end - p);
+    }
+
+    // writes x >= 0, which has at most width <= 2 * DEC_DIGS * 2^k digits, as exactly width
+    // characters zero padded on the left; splits by dec_power(k) into quotient and remainder
+    void BigInt::dec_write(const BigInt &x, size_t k, char *out, size_t width)
+    {
+        if (x.d.size() <= DEC_DC_THRESHOLD)
+        {
+            size_t len = dec_basecase(x.d.data(), x.d.size(), out + width);
+            std::fill(out, out + (width - len), '0');
+            return;
+        }
+        size_t half = static_cast<size_t>(DEC_DIGS) << k;
+        if (width <= half)
+        {
+            dec_write(x, k - 1, out, width);
+            return;
+        }
+        BigInt q;
+        BigInt r;
+        div_mod(x, dec_power(k), q, r);
+        dec_write(q, k - 1, out, width - half);
+        dec_write(r, k - 1, out + (width - half), half);
+    }
+
+    size_t BigInt::decimal_size() const
+    {
+        size_t sign = neg ? 1u : 0u;
+        if (d.size() <= DEC_DC_THRESHOLD)
+        {
+            char buf[DEC_DC_THRESHOLD * 20];
+            size_t len = dec_basecase(d.data(), d.size(), buf + sizeof(buf));
+            return sign + (len == 0 ? 1u : len);
+        }
+
+        // raise the lower bound while |x| >= 10^digits
+
+        size_t digits = dec_digits_lower(bit_length());
+        while (cmp_abs(*this, dec_pow10(digits)) >= 0)
+        {
+            digits += 1;
+        }
+        return sign + digits;
+    }
+
+    std::to_chars_result BigInt::to_chars(char *first, char *last) const
+    {
+        size_t room = static_cast<size_t>(last - first);
+        if (d.size() <= DEC_DC_THRESHOLD)
+        {
+            char buf[DEC_DC_THRESHOLD * 20 + 2];
+            char *end = buf + sizeof(buf);
+            char *begin = end - dec_basecase(d.data(), d.size(), end);
+            if (begin == end)
+            {
+                begin -= 1;
+                *begin = '0';
+            }
+            if (neg)
+            {
+                begin -= 1;
+                *begin = '-';
+            }
+            size_t total = static_cast<size_t>(end - begin);
+            if (room < total)
+            {
+                return {last, std::errc::value_too_large};
+            }
+            std::memcpy(first, begin, total);
+            return {first + total, std::errc()};
+        }
+
+        // format into the upper bound width and drop the (at most two) leading zeros;
+        // only a buffer between the bounds needs the exact decimal_size
+
+        size_t sign = neg ? 1u : 0u;
+        size_t width = dec_digits_lower(bit_length()) + 2u;
+        if (room < sign + width)
+        {
+            width = decimal_size() - sign;
+            if (room < sign + width)
+            {
+                return {last, std::errc::value_too_large};
+            }
+        }
+        char *p = first + sign;
+        if (neg)
+        {
+            *first = '-';
+        }
+        size_t k = 0;
+        while ((static_cast<size_t>(DEC_DIGS) << (k + 1)) < width)
+        {
+            k += 1;
+        }
+        BigInt x = *this;
+        x.neg = false;
+        dec_write(x, k, p, width);
+        size_t zeros = 0;
+        while (p[zeros] == '0')
+        {
+            zeros += 1;
+        }
+        std::memmove(p, p + zeros, width - zeros);
+        return {p + (width - zeros), std::errc()};
+    }
+
+    std::string BigInt::to_string() const
+    {
+        if (d.size() <= DEC_DC_THRESHOLD)
+        {
+            char buf[DEC_DC_THRESHOLD * 20 + 2];
+            std::to_chars_result r = to_chars(buf, buf + sizeof(buf));
+            return std::string(buf, r.ptr);
+        }
+        std::string s(1u + dec_digits_lower(bit_length()) + 2u, '0');
+        std::to_chars_result r = to_chars(s.data(), s.data() + s.size());
+        s.resize(static_cast<size_t>(r.ptr - s.data()));
+        return s;
+    }
+
+    std::span<const uint64_t> BigInt::limbs() const
+    {
+        return std::span<const uint64_t>(d.data(), d.size());
+    }
+
+    bool BigInt::is_negative() const
+    {
+        return neg;
+    }
+
+    BigInt BigInt::from_limbs(std::vector<uint64_t> limbs, bool negative)
+    {
+        BigInt r;
+        r.d.assign(limbs.data(), limbs.data() + limbs.size());
+        r.neg = negative;
+        r.trim();
+        return r;
+    }
+
+    bool BigInt::is_zero() const
+    {
+        return d.empty();
+    }
+
+    bool BigInt::is_odd() const
+    {
+        return !d.empty() && (d[0] & 1u) != 0;
+    }
+
+    size_t BigInt::bit_length() const
+    {
+        if (d.empty())
+        {
+            return 0;
+        }
+        return d.size() * 64u - static_cast<size_t>(std::countl_zero(d.back()));
+    }
+
+    bool BigInt::test_bit(size_t i) const
+    {
+        size_t limb = i / 64u;
+        if (limb >= d.size())
+        {
+            return false;
+        }
+        return ((d[limb] >> (i % 64u)) & 1u) != 0;
+    }
+
+    BigInt &BigInt::operator<<=(size_t bits)
+    {
+        if (d.empty() || bits == 0)
+        {
+            return *this;
+        }
+        size_t w = bits / 64u;
+        unsigned s = static_cast<unsigned>(bits % 64u);
+        size_t n = d.size();
+        uint64_t top = s == 0 ? 0u : d[n - 1] >> (64u - s);
+        d.resize(n + w + 1, 0u);
+        d[n + w] = top;
+        size_t i = n;
+        while (i > 0)
+        {
+            uint64_t lo = i > 1 ? d[i - 2] : 0u;
+            d[i - 1 + w] = s == 0 ? d[i - 1] : (d[i - 1] << s) | (lo >> (64u - s));
+            i -= 1;
+        }
+        std::fill(d.begin(), d.begin() + static_cast<long>(w), 0u);
+        trim();
+        return *this;
+    }
+
+    BigInt &BigInt::operator>>=(size_t bits)
+    {
+        size_t w = bits / 64u;
+        if (w >= d.size())
+        {
+            d.clear();
+            neg = false;
+            return *this;
+        }
+        unsigned s = static_cast<unsigned>(bits % 64u);
+        size_t n = d.size() - w;
+        size_t i = 0;
+        while (i < n)
+        {
+            uint64_t hi = i + 1 < n ? d[i + w + 1] : 0u;
+            d[i] = s == 0 ? d[i + w] : (d[i + w] >> s) | (hi << (64u - s));
+            i += 1;
+        }
+        d.resize(n);
+        trim();
+        return *this;
+    }
+
+    BigInt operator<<(BigInt lhs, size_t bits)
+    {
+        lhs <<= bits;
+        return lhs;
+    }
+
+    BigInt operator>>(BigInt lhs, size_t bits)
+    {
+        lhs >>= bits;
+        return lhs;
+    }
+
+    uint32_t BigInt::divmod_small(uint32_t m)
+    {
+        if (m == 0)
+        {
+            throw std::domain_error("division by zero");
+        }
+        uint32_t rem = static_cast<uint32_t>(div_small(d, m));
+        if (d.empty())
+        {
+            neg = false;
+        }
+        return rem;
+    }
+
+    BigInt::BigInt(const BigInt &other) : d(other.d), neg(other.neg)
+    {
+    }
+
+    BigInt::BigInt(BigInt &&other) noexcept : d(std::move(other.d)), neg(other.neg)
+    {
+        other.neg = false;
+    }
+
+    BigInt &BigInt::operator=(const BigInt &other)
+    {
+        if (this != &other)
+        {
+            d = other.d;
+            neg = other.neg;
+        }
+        return *this;
+    }
+
+    BigInt &BigInt::operator=(BigInt &&other) noexcept
+    {
+        if (this != &other)
+        {
+            d = std::move(other.d);
+            neg = other.neg;
+            other.neg = false;
+        }
+        return *this;
+    }
+
+    void BigInt::trim()
+    {
+        while (!d.empty() && d.back() == 0u)
+        {
+            d.pop_back();
+        }
+        if (d.empty())
+        {
+            neg = false;
+        }
+    }
+
+    int BigInt::cmp_abs(const BigInt &a, const BigInt &b)
+    {
+        if (a.d.size() > b.d.size())
+        {
+            return 1;
+        }
+        if (a.d.size() < b.d.size())
+        {
+            return -1;
+        }
+        size_t n = a.d.size();
+        while (n > 0)
+        {
+            uint64_t x = a.d[n - 1];
+            uint64_t y = b.d[n - 1];
+            if (x > y)
+            {
+                return 1;
+            }
+            if (x < y)
+            {
+                return -1;
+            }
+            n -= 1;
+        }
+        return 0;
+    }
+
+    BigInt BigInt::add_abs(const BigInt &a, const BigInt &b)
+    {
+        const BigInt &x = a.d.size() >= b.d.size() ? a : b;
+        const BigInt &y = a.d.size() >= b.d.size() ? b : a;
+        size_t n = x.d.size();
+        BigInt r;
+        r.d.resize(n + 1u, 0u);
+        r.d[n] = limb_add(r.d.data(), x.d.data(), n, y.d.data(), y.d.size());
+        r.neg = false;
+        r.trim();
+        return r;
+    }
+
+    BigInt BigInt::sub_abs(const BigInt &a, const BigInt &b)
+    {
+        BigInt r;
+        r.d.resize(a.d.size(), 0u);
+        limb_sub(r.d.data(), a.d.data(), a.d.size(), b.d.data(), b.d.size());
+        r.neg = false;
+        r.trim();
+        return r;
+    }
+
+    BigInt BigInt::mul_abs(const BigInt &a, const BigInt &b)
+    {
+        BigInt r;
+        if (a.d.empty() || b.d.empty())
+        {
+            return r;
+        }
+        r.d.resize(a.d.size() + b.d.size());
+        limb_mul_basecase(r.d.data(), a.d.data(), a.d.size(), b.d.data(), b.d.size());
+        r.neg = false;
+        r.trim();
+        return r;
+    }
+
+    bool BigInt::sub_inplace(LimbVec &x, const LimbVec &y)
+    {
+        if (x.size() < y.size())
+        {
+            return false;
+        }
+        uint64_t borrow = limb_sub_in(x.data(), x.size(), y.data(), y.size());
+        if (borrow != 0)
+        {
+            return false;
+        }
+        while (!x.empty() && x.back() == 0u)
+        {
+            x.pop_back();
+        }
+        return true;
+    }
+
+    void BigInt::mul_small_add(LimbVec &x, uint64_t m, uint64_t a)
+    {
+        uint64_t carry = a;
+        size_t i = 0;
+        while (i < x.size())
+        {
+            u128 cur = static_cast<u128>(x[i]) * m + carry;
+            x[i] = static_cast<uint64_t>(cur);
+            carry = static_cast<uint64_t>(cur >> 64);
+            i += 1;
+        }
+        if (carry != 0)
+        {
+            x.push_back(carry);
+        }
+    }
+
+    uint64_t BigInt::div_small(LimbVec &x, uint64_t m)
+    {
+        uint64_t rem = 0;
+        size_t i = x.size();
+        while (i > 0)
+        {
+            u128 cur = (static_cast<u128>(rem) << 64) | x[i - 1];
+            x[i - 1] = static_cast<uint64_t>(cur / m);
+            rem = static_cast<uint64_t>(cur % m);
+            i -= 1;
+        }
+        while (!x.empty() && x.back() == 0u)
+        {
+            x.pop_back();
+        }
+        return rem;
+    }
+
+    void BigInt::div_mod(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
+    {
+        if (b.d.empty())
+        {
+            throw std::domain_error("division by zero");
+        }
+        size_t bz = thresholds().burnikel_ziegler;
+        if (b.d.size() >= bz && a.d.size() >= b.d.size() + bz)
+        {
+            div_mod_bz(a, b, q, r);
+            return;
+        }
+        div_mod_schoolbook(a, b, q, r);
+    }
+
+    void BigInt::div_mod_schoolbook(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
+    {
+        if (b.d.empty())
+        {
+            throw std::domain_error("division by zero");
+        }
+        if (a.d.empty())
+        {
+            q.d.clear();
+            q.neg = false;
+            r.d.clear();
+            r.neg = false;
+            return;
+        }
+        int cmp = cmp_abs(a, b);
+        if (cmp < 0)
+        {
+            q.d.clear();
+            q.neg = false;
+            r = a;
+            r.neg = false;
+            return;
+        }
+        if (cmp == 0)
+        {
+            q.d.assign(1, 1u);
+            q.neg = false;
+            r.d.clear();
+            r.neg = false;
+            return;
+        }
+
+        size_t n = b.d.size();
+        size_t m = a.d.size() - n;
+
+        // single limb divisor: plain short division
+
+        if (n == 1)
+        {
+            q.d = a.d;
+            uint64_t rem = div_small(q.d, b.d[0]);
+            r.d.clear();
+            if (rem != 0)
+            {
+                r.d.push_back(rem);
+            }
+            q.neg = false;
             r.neg = false;
             return;
         }
 
-        auto trim_vec = [](std::vector<uint32_t> &v)
+        // Knuth, TAOCP vol. 2, 4.3.1, Algorithm D
+        // shift both operands left so that the top bit of the divisor is set
+
+        unsigned sh = static_cast<unsigned>(std::countl_zero(b.d[n - 1]));
+
+        std::vector<uint64_t> u(a.d.size() + 1, 0u);
+        std::vector<uint64_t> v(n, 0u);
+        size_t i = 0;
+        while (i < a.d.size())
+        {
+            u[i] = a.d[i] << sh;
+            if (sh != 0 && i > 0)
+            {
+                u[i] |= a.d[i - 1] >> (64u - sh);
+            }
+            i += 1;
+        }
+        if (sh != 0)
+        {
+            u[a.d.size()] = a.d.back() >> (64u - sh);
+        }
+        i = 0;
+        while (i < n)
+        {
+            v[i] = b.d[i] << sh;
+            if (sh != 0 && i > 0)
+            {
+                v[i] |= b.d[i - 1] >> (64u - sh);
+            }
+            i += 1;
+        }
+
+        uint64_t vtop = v[n - 1];
+        uint64_t vnext = v[n - 2];
+
+        q.d.assign(m + 1, 0u);
+        q.neg = false;
+
+        size_t j = m + 1;
+        while (j > 0)
+        {
+            j -= 1;
+
+            // estimate the quotient limb from the top two limbs, at most two corrections
+
+            u128 num = (static_cast<u128>(u[j + n]) << 64) | u[j + n - 1];
+            u128 qhat = num / vtop;
+            u128 rhat = num % vtop;
+            while ((qhat >> 64) != 0 || qhat * vnext > ((rhat << 64) | u[j + n - 2]))
+            {
+                qhat -= 1;
+                rhat += vtop;
+                if ((rhat >> 64) != 0)
+                {
+                    break;
+                }
+            }
+
+            // u[j .. j + n] -= qhat * v
+
+            uint64_t borrow = 0;
+            uint64_t carry = 0;
+            i = 0;
+            while (i < n)
+            {
+                u128 p = qhat * v[i] + carry;
+                carry = static_cast<uint64_t>(p >> 64);
+                uint64_t lo = static_cast<uint64_t>(p);
+                uint64_t x = u[i + j];
+                u[i + j] = x - lo - borrow;
+                borrow = (x < lo || (x == lo && borrow != 0)) ? 1u : 0u;
+                i += 1;
+            }
+            uint64_t x = u[j + n];
+            uint64_t top = x - carry - borrow;
+            bool negative = x < carry || (x == carry && borrow != 0);
+
+            // qhat was one too large: add the divisor back
+
+            if (negative)
+            {
+                qhat -= 1;
+                carry = 0;
+                i = 0;
+                while (i < n)
+                {
+                    u128 s = static_cast<u128>(u[i + j]) + v[i] + carry;
+                    u[i + j] = static_cast<uint64_t>(s);
+                    carry = static_cast<uint64_t>(s >> 64);
+                    i += 1;
+                }
+                top += carry;
+            }
+            u[j + n] = top;
+            q.d[j] = static_cast<uint64_t>(qhat);
+        }
+
+        // remainder is u[0 .. n - 1] shifted back
+
+        r.d.assign(n, 0u);
+        i = 0;
+        while (i < n)
+        {
+            r.d[i] = u[i] >> sh;
+            if (sh != 0 && i + 1 < n)
+            {
+                r.d[i] |= u[i + 1] << (64u - sh);
+            }
+            i += 1;
+        }
+
+        q.neg = false;
+        r.neg = false;
+        q.trim();
+        r.trim();
+    }
+
+    BigInt &BigInt::operator+=(const BigInt &rhs)
+    {
+        if (neg == rhs.neg)
+        {
+            *this = add_abs(*this, rhs);
+            neg = rhs.neg;
+            return *this;
+        }
+        else
+        {
+            int c = cmp_abs(*this, rhs);
+            if (c >= 0)
+            {
+                bool sign = neg;
+                *this = sub_abs(*this, rhs);
+                if (d.empty())
+                {
+                    neg = false;
+                }
+                else
+                {
+                    neg = sign;
+                }
+                return *this;
+            }
+            else
+            {
+                BigInt t = sub_abs(rhs, *this);
+                t.neg = rhs.neg;
+                *this = std::move(t);
+                return *this;
+            }
+        }
+    }
+
+    BigInt &BigInt::operator-=(const BigInt &rhs)
+    {
+        if (neg != rhs.neg)
+        {
+            bool sign = neg;
+            *this = add_abs(*this, rhs);
+            neg = sign;
+            return *this;
+        }
+        else
+        {
+            int c = cmp_abs(*this, rhs);
+            if (c >= 0)
+            {
+                bool sign = neg;
+                *this = sub_abs(*this, rhs);
+                if (d.empty())
+                {
+                    neg = false;
+                }
+                else
+                {
+                    neg = sign;
+                }
+                return *this;
+            }
+            else
+            {
+                BigInt t = sub_abs(rhs, *this);
+                t.neg = !neg;
+                *this = std::move(t);
+                return *this;
+            }
+        }
+    }
+
+    BigInt &BigInt::operator*=(const BigInt &rhs)
+    {
+        mul_into(*this, *this, rhs);
+        return *this;
+    }
+
+    void mul_into(BigInt &dest, const BigInt &a, const BigInt &b)
+    {
+        size_t n = a.d.size();
+        size_t m = b.d.size();
+        bool sign = (a.neg != b.neg);
+        if (n == 0 || m == 0)
+        {
+            dest.d.clear();
+            dest.neg = false;
+            return;
+        }
+        bool square = (&a == &b);
+
+        // Toom-Cook and NTT build their own temporaries, so the product is moved in
+
+        const BigInt::Thresholds &t = BigInt::thresholds();
+        size_t above = std::min({t.toom3, t.toom4, t.ntt});
+        bool large = square ? n >= above : std::min(n, m) >= above;
+        if (large)
+        {
+            BigInt r = square ? BigInt::sqr_abs(a) : BigInt::mul_tiered_abs(a, b);
+            dest = std::move(r);
+            dest.neg = sign;
+            return;
+        }
+
+        // schoolbook and Karatsuba write straight into dest unless it is an operand,
+        // in which case the product goes through the scratch arena first
+
+        const uint64_t *x = n >= m ? a.d.data() : b.d.data();
+        const uint64_t *y = n >= m ? b.d.data() : a.d.data();
+        size_t xn = std::max(n, m);
+        size_t yn = std::min(n, m);
+        size_t pn = n + m;
+        bool alias = (&dest == &a || &dest == &b);
+        size_t ws_size = square ? BigInt::kara_sqr_scratch(n) : BigInt::kara_scratch(xn, yn);
+        uint64_t *ws = scratch_arena(ws_size + (alias ? pn : 0u));
+        uint64_t *r = ws + ws_size;
+        if (!alias)
+        {
+            dest.d.clear();
+            dest.d.resize(pn, 0u);
+            r = dest.d.data();
+        }
+        if (square)
+        {
+            BigInt::kara_sqr_n(r, x, n, ws);
+        }
+        else
+        {
+            BigInt::kara_mul(r, x, xn, y, yn, ws);
+        }
+        if (alias)
+        {
+            dest.d.assign(r, r + pn);
+        }
+        dest.neg = sign;
+        dest.trim();
+    }
+
+    // *this += (subtract ? -1 : 1) * a * b; a or b may be *this
+    BigInt &BigInt::mul_accumulate(const BigInt &a, const BigInt &b, bool subtract)
+    {
+        size_t an = a.d.size();
+        size_t bn = b.d.size();
+        if (an == 0 || bn == 0)
+        {
+            return *this;
+        }
+        bool pneg = (a.neg != b.neg) != subtract;
+        size_t kara = thresholds().karatsuba;
+        if (an >= kara || bn >= kara)
+        {
+            BigInt p = a * b;
+            p.neg = pneg;
+            return *this += p;
+        }
+
+        // |a * b| into the arena, complete before *this is touched
+
+        size_t pn = an + bn;
+        uint64_t *p = scratch_arena(pn);
+        if (&a == &b)
+        {
+            limb_sqr_basecase(p, a.d.data(), an);
+        }
+        else if (an >= bn)
+        {
+            limb_mul_basecase(p, a.d.data(), an, b.d.data(), bn);
+        }
+        else
+        {
+            limb_mul_basecase(p, b.d.data(), bn, a.d.data(), an);
+        }
+        while (p[pn - 1] == 0u)
+        {
+            pn -= 1;
+        }
+
+        size_t n = d.size();
+        if (n == 0 || neg == pneg)
+        {
+            size_t top = std::max(n, pn) + 1u;
+            d.resize(top, 0u);
+            limb_add_in(d.data(), top, p, pn);
+            neg = pneg;
+            trim();
+            return *this;
+        }
+
+        // opposite signs: subtract the smaller magnitude from the larger
+
+        int c = n < pn ? -1 : (n > pn ? 1 : 0);
+        size_t i = n;
+        while (c == 0 && i > 0)
+        {
+            i -= 1;
+            if (d[i] != p[i])
+            {
+                c = d[i] < p[i] ? -1 : 1;
+            }
+        }
+        if (c >= 0)
+        {
+            limb_sub_in(d.data(), n, p, pn);
+        }
+        else
+        {
+            d.resize(pn, 0u);
+            limb_sub(d.data(), p, pn, d.data(), n);
+            neg = pneg;
+        }
+        trim();
+        return *this;
+    }
+
+    BigInt &BigInt::addmul(const BigInt &a, const BigInt &b)
+    {
+        return mul_accumulate(a, b, false);
+    }
+
+    BigInt &BigInt::submul(const BigInt &a, const BigInt &b)
+    {
+        return mul_accumulate(a, b, true);
+    }
+
+    BigInt fma(const BigInt &a, const BigInt &b, const BigInt &c)
+    {
+        BigInt r;
+        r.d.reserve(std::max(c.d.size(), a.d.size() + b.d.size()) + 1u);
+        r.d.assign(c.d.begin(), c.d.end());
+        r.neg = c.neg;
+        r.addmul(a, b);
+        return r;
+    }
+
+    BigInt &BigInt::operator/=(const BigInt &rhs)
+    {
+        if (rhs.d.empty())
+        {
+            throw std::domain_error("division by zero");
+        }
+        BigInt qa;
+        BigInt ra;
+        BigInt aa = *this;
+        aa.neg = false;
+        BigInt bb = rhs;
+        bb.neg = false;
+        div_mod(aa, bb, qa, ra);
+        if (!qa.d.empty())
+        {
+            qa.neg = neg != rhs.neg;
+        }
+        else
+        {
+            qa.neg = false;
+        }
+        *this = std::move(qa);
+        return *this;
+    }
+
+    BigInt operator+(BigInt lhs, const BigInt &rhs)
+    {
+        lhs += rhs;
+        return lhs;
+    }
+
+    BigInt operator-(BigInt lhs, const BigInt &rhs)
+    {
+        lhs -= rhs;
+        return lhs;
+    }
+
+    BigInt operator*(const BigInt &lhs, const BigInt &rhs)
+    {
+        BigInt r;
+        mul_into(r, lhs, rhs);
+        return r;
+    }
+
+    BigInt operator/(BigInt lhs, const BigInt &rhs)
+    {
+        lhs /= rhs;
+        return lhs;
+    }
+
+    bool operator==(const BigInt &a, const BigInt &b)
+    {
+        if (a.neg != b.neg)
         {
-            while (!v.empty() && v.back() == 0u)
+            if (a.d.empty() && b.d.empty())
             {
-                v.pop_back();
+                return true;
             }
-        };
+            return false;
+        }
+        if (a.d.size() != b.d.size())
+        {
+            return false;
+        }
+        size_t i = 0;
+        while (i < a.d.size())
+        {
+            if (a.d[i] != b.d[i])
+            {
+                return false;
+            }
+            i += 1;
+        }
+        return true;
+    }
 
-        q.d.assign(a.d.size(), 0u);
-        q.neg = false;
-        r.d.clear();
-        r.neg = false;
-        r.d.reserve(a.d.size());
+    bool operator!=(const BigInt &a, const BigInt &b)
+    {
+        return !(a == b);
+    }
 
-        size_t i = a.d.size();
-        while (i > 0)
+    bool operator<(const BigInt &a, const BigInt &b)
+    {
+        if (a.neg != b.neg)
+        {
+            if (a.neg)
+            {
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        int c = BigInt::cmp_abs(a, b);
+        if (!a.neg)
+        {
+            if (c < 0)
+            {
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else
         {
-            r.d.insert(r.d.begin(), 0u);
-            r.d[0] = a.d[i - 1];
-            while (!r.d.empty() && r.d.back() == 0u)
+            if (c > 0)
+            {
+                return true;
+            }
+            else
             {
-                r.d.pop_back();
+                return false;
             }
+        }
+    }
 
-            uint32_t low = 0;
-            uint32_t high = BASE - 1;
-            uint32_t best = 0;
+    bool operator>(const BigInt &a, const BigInt &b)
+    {
+        return b < a;
+    }
 
-            while (low <= high)
-            {
-                uint32_t mid = static_cast<uint32_t>(low + (static_cast<uint64_t>(high - low) / 2));
-                std::vector<uint32_t> prod(b.d.size() + 1, 0u);
-                uint64_t carry = 0;
-                size_t j = 0;
-                while (j < b.d.size())
-                {
-                    uint64_t cur = static_cast<uint64_t>(b.d[j]) * mid + carry;
-                    prod[j] = static_cast<uint32_t>(cur % BASE);
-                    carry = cur / BASE;
-                    j += 1;
-                }
-                prod[b.d.size()] = static_cast<uint32_t>(carry);
-                trim_vec(prod);
+    bool operator<=(const BigInt &a, const BigInt &b)
+    {
+        return !(b < a);
+    }
 
-                std::vector<uint32_t> rr = r.d;
-                bool ok = sub_inplace(rr, prod);
-                if (ok)
-                {
-                    best = mid;
-                    low = mid + 1;
-                }
-                else
-                {
-                    if (mid == 0)
-                    {
-                        break;
-                    }
-                    high = static_cast<uint32_t>(mid - 1);
-                }
-            }
+    bool operator>=(const BigInt &a, const BigInt &b)
+    {
+        return !(a < b);
+    }
+
+    std::ostream &operator<<(std::ostream &os, const BigInt &v)
+    {
+        if (v.d.size() <= BigInt::DEC_DC_THRESHOLD)
+        {
+            char buf[BigInt::DEC_DC_THRESHOLD * 20 + 2];
+            std::to_chars_result r = v.to_chars(buf, buf + sizeof(buf));
+            os << std::string_view(buf, static_cast<size_t>(r.ptr - buf));
+            return os;
+        }
+        os << v.to_string();
+        return os;
+    }
 
-            q.d[i - 1] = best;
+    std::istream &operator>>(std::istream &is, BigInt &v)
+    {
+        std::string s;
+        if (!(is >> s))
+        {
+            return is;
+        }
+        v = BigInt::from_string(s);
+        return is;
+    }
 
-            if (best > 0)
-            {
-                std::vector<uint32_t> prod(b.d.size() + 1, 0u);
-                uint64_t carry = 0;
-                size_t j = 0;
-                while (j < b.d.size())
-                {
-                    uint64_t cur = static_cast<uint64_t>(b.d[j]) * best + carry;
-                    prod[j] = static_cast<uint32_t>(cur % BASE);
-                    carry = cur / BASE;
-                    j += 1;
-                }
-                prod[b.d.size()] = static_cast<uint32_t>(carry);
-                trim_vec(prod);
-                sub_inplace(r.d, prod);
-            }
+    // Karatsuba
 
-            i -= 1;
+    void BigInt::split_at(const BigInt &a, size_t k, BigInt &low, BigInt &high)
+    {
+        low.d.clear();
+        high.d.clear();
+        if (a.d.size() <= k)
+        {
+            low.d = a.d;
+            low.neg = false;
+            high.neg = false;
+            return;
         }
+        low.d.assign(a.d.begin(), a.d.begin() + static_cast<long>(k));
+        high.d.assign(a.d.begin() + static_cast<long>(k), a.d.end());
+        low.neg = false;
+        high.neg = false;
+        low.trim();
+        high.trim();
+    }
 
-        while (!q.d.empty() && q.d.back() == 0u)
+    BigInt BigInt::shift_base_abs(const BigInt &a, size_t k)
+    {
+        if (a.d.empty())
+        {
+            BigInt z;
+            return z;
+        }
+        BigInt r;
+        r.d.resize(a.d.size() + k);
+        size_t i = 0;
+        while (i < k)
+        {
+            r.d[i] = 0u;
+            i += 1;
+        }
+        size_t j = 0;
+        while (j < a.d.size())
         {
-            q.d.pop_back();
+            r.d[k + j] = a.d[j];
+            j += 1;
         }
         r.neg = false;
-        q.neg = false;
-        q.trim();
-        r.trim();
+        return r;
     }
 
-    BigInt &BigInt::operator+=(const BigInt &rhs)
+    // thresholds
+
+    // Karatsuba halves must come out below the threshold (see kara_mul_n, kara_sqr_n),
+    // Toom pieces plus their evaluation carries likewise, and the Burnikel-Ziegler
+    // padding loop halves the divisor until it is below its threshold
+
+    static constexpr bool thresholds_valid(const BigInt::Thresholds &t)
     {
-        if (neg == rhs.neg)
+        return t.karatsuba >= 4 && t.karatsuba_sqr >= 4 && t.toom3 >= 8 && t.toom4 >= 8 && t.ntt >= 1 &&
+               t.burnikel_ziegler >= 2;
+    }
+
+#ifdef BIGINT_TUNED_KERNELS
+    static_assert(thresholds_valid({BIGINT_TUNED_KARATSUBA, BIGINT_TUNED_KARATSUBA_SQR, BIGINT_TUNED_TOOM3,
+                                    BIGINT_TUNED_TOOM4, BIGINT_TUNED_NTT, BIGINT_TUNED_BURNIKEL_ZIEGLER}),
+                  "bigint_tuned.hpp holds a threshold below what set_thresholds accepts");
+#endif
+
+    BigInt::Thresholds BigInt::default_thresholds()
+    {
+#ifdef BIGINT_TUNED_KERNELS
+        if (std::strcmp(limb_kernels().name, BIGINT_TUNED_KERNELS) == 0)
         {
-            *this = add_abs(*this, rhs);
-            neg = rhs.neg;
-            return *this;
+            return {BIGINT_TUNED_KARATSUBA, BIGINT_TUNED_KARATSUBA_SQR, BIGINT_TUNED_TOOM3,
+                    BIGINT_TUNED_TOOM4, BIGINT_TUNED_NTT, BIGINT_TUNED_BURNIKEL_ZIEGLER};
         }
-        else
+#endif
+        if (limb_kernels().ifma)
         {
-            int c = cmp_abs(*this, rhs);
-            if (c >= 0)
-            {
-                *this = sub_abs(*this, rhs);
-                if (this->d.empty())
-                {
-                    neg = false;
-                }
-                return *this;
-            }
-            else
-            {
-                BigInt t = sub_abs(rhs, *this);
-                t.neg = rhs.neg;
-                *this = std::move(t);
-                return *this;
-            }
+            return {IFMA_KARATSUBA_THRESHOLD, IFMA_KARATSUBA_SQR_THRESHOLD, IFMA_TOOM3_THRESHOLD,
+                    IFMA_TOOM4_THRESHOLD, IFMA_NTT_THRESHOLD, BURNIKEL_ZIEGLER_THRESHOLD};
         }
+        return {KARATSUBA_THRESHOLD, KARATSUBA_SQR_THRESHOLD, TOOM3_THRESHOLD,
+                TOOM4_THRESHOLD, NTT_THRESHOLD, BURNIKEL_ZIEGLER_THRESHOLD};
     }
 
-    BigInt &BigInt::operator-=(const BigInt &rhs)
+    const char *BigInt::kernel_set()
     {
-        if (neg != rhs.neg)
+        return limb_kernels().name;
+    }
+
+    static BigInt::Thresholds &threshold_table()
+    {
+        static BigInt::Thresholds t = BigInt::default_thresholds();
+        return t;
+    }
+
+    const BigInt::Thresholds &BigInt::thresholds()
+    {
+        return threshold_table();
+    }
+
+    void BigInt::set_thresholds(const Thresholds &t)
+    {
+        if (!thresholds_valid(t))
         {
-            bool sign = neg;
-            *this = add_abs(*this, rhs);
-            neg = sign;
-            return *this;
+            throw std::invalid_argument("threshold too small");
         }
-        else
+        threshold_table() = t;
+    }
+
+    size_t BigInt::kara_scratch(size_t an, size_t bn)
+    {
+        if (bn < thresholds().karatsuba)
         {
-            int c = cmp_abs(*this, rhs);
-            if (c >= 0)
+            return 0;
+        }
+        if (an == bn)
+        {
+            size_t hi = bn - bn / 2;
+            return 4u * (hi + 1u) + kara_scratch(hi + 1u, hi + 1u);
+        }
+        size_t inner = kara_scratch(bn, bn);
+        size_t rest = an % bn;
+        if (rest != 0)
+        {
+            inner = std::max(inner, kara_scratch(bn, rest));
+        }
+        return 2u * bn + inner;
+    }
+
+    // r[0 .. 2n) = a[0 .. n) * b[0 .. n); ws holds kara_scratch(n, n) limbs
+    void BigInt::kara_mul_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n, uint64_t *ws)
+    {
+        if (n < thresholds().karatsuba)
+        {
+            limb_mul_basecase(r, a, n, b, n);
+            return;
+        }
+        size_t lo = n / 2;
+        size_t hi = n - lo;
+
+        uint64_t *sa = ws;
+        uint64_t *sb = sa + hi + 1;
+        uint64_t *z1 = sb + hi + 1;
+        uint64_t *next = z1 + 2u * (hi + 1);
+
+        sa[hi] = limb_add(sa, a + lo, hi, a, lo);
+        sb[hi] = limb_add(sb, b + lo, hi, b, lo);
+
+        kara_mul_n(r, a, b, lo, next);
+        kara_mul_n(r + 2u * lo, a + lo, b + lo, hi, next);
+        kara_mul_n(z1, sa, sb, hi + 1, next);
+
+        limb_sub_in(z1, 2u * hi + 2u, r, 2u * lo);
+        limb_sub_in(z1, 2u * hi + 2u, r + 2u * lo, 2u * hi);
+        limb_add_in(r + lo, 2u * n - lo, z1, 2u * hi + 2u);
+    }
+
+    // r[0 .. an + bn) = a * b for an >= bn; ws holds kara_scratch(an, bn) limbs
+    void BigInt::kara_mul(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn, uint64_t *ws)
+    {
+        if (bn < thresholds().karatsuba)
+        {
+            limb_mul_basecase(r, a, an, b, bn);
+            return;
+        }
+        if (an == bn)
+        {
+            kara_mul_n(r, a, b, an, ws);
+            return;
+        }
+
+        // unbalanced: multiply b by bn-limb chunks of a and accumulate
+
+        kara_mul_n(r, a, b, bn, ws + 2u * bn);
+        std::fill(r + 2u * bn, r + an + bn, 0u);
+        uint64_t *t = ws;
+        size_t off = bn;
+        while (off < an)
+        {
+            size_t len = std::min(bn, an - off);
+            if (len == bn)
             {
-                bool sign = neg;
-                *this = sub_abs(*this, rhs);
-                if (d.empty())
-                {
-                    neg = false;
-                }
-                else
-                {
-                    neg = sign;
-                }
-                return *this;
+                kara_mul_n(t, a + off, b, bn, ws + 2u * bn);
             }
             else
             {
-                BigInt t = sub_abs(rhs, *this);
-                t.neg = !neg;
-                *this = std::move(t);
-                return *this;
+                kara_mul(t, b, bn, a + off, len, ws + 2u * bn);
             }
+            limb_add_in(r + off, an + bn - off, t, len + bn);
+            off += len;
+        }
+    }
+
+    BigInt BigInt::mul_karatsuba_abs(const BigInt &a, const BigInt &b)
+    {
+        BigInt r;
+        if (a.d.empty() || b.d.empty())
+        {
+            return r;
+        }
+        const BigInt &x = a.d.size() >= b.d.size() ? a : b;
+        const BigInt &y = a.d.size() >= b.d.size() ? b : a;
+        size_t n = x.d.size();
+        size_t m = y.d.size();
+
+        uint64_t *ws = scratch_arena(kara_scratch(n, m));
+        r.d.resize(n + m);
+        kara_mul(r.d.data(), x.d.data(), n, y.d.data(), m, ws);
+        r.neg = false;
+        r.trim();
+        return r;
+    }
+
+    size_t BigInt::kara_sqr_scratch(size_t n)
+    {
+        if (n < thresholds().karatsuba_sqr)
+        {
+            return 0;
+        }
+        size_t hi = n - n / 2;
+        return 3u * (hi + 1u) + kara_sqr_scratch(hi + 1u);
+    }
+
+    // r[0 .. 2n) = a[0 .. n)^2 from three half-size squarings; ws holds kara_sqr_scratch(n) limbs
+    void BigInt::kara_sqr_n(uint64_t *r, const uint64_t *a, size_t n, uint64_t *ws)
+    {
+        if (n < thresholds().karatsuba_sqr)
+        {
+            limb_sqr_basecase(r, a, n);
+            return;
         }
+        size_t lo = n / 2;
+        size_t hi = n - lo;
+
+        uint64_t *sa = ws;
+        uint64_t *z1 = sa + hi + 1;
+        uint64_t *next = z1 + 2u * (hi + 1);
+
+        sa[hi] = limb_add(sa, a + lo, hi, a, lo);
+
+        kara_sqr_n(r, a, lo, next);
+        kara_sqr_n(r + 2u * lo, a + lo, hi, next);
+        kara_sqr_n(z1, sa, hi + 1, next);
+
+        limb_sub_in(z1, 2u * hi + 2u, r, 2u * lo);
+        limb_sub_in(z1, 2u * hi + 2u, r + 2u * lo, 2u * hi);
+        limb_add_in(r + lo, 2u * n - lo, z1, 2u * hi + 2u);
     }
 
-    BigInt &BigInt::operator*=(const BigInt &rhs)
+    BigInt BigInt::sqr_abs(const BigInt &a)
     {
-        bool sign = false;
-        if (neg != rhs.neg)
+        size_t n = a.d.size();
+        const Thresholds &t = thresholds();
+        if (n >= t.ntt)
         {
-            sign = true;
+            return mul_ntt_abs(a, a);
         }
-        BigInt r = mul_abs(*this, rhs);
-        r.neg = false;
-        if (r.d.empty())
+        if (n >= t.toom4)
         {
-            r.neg = false;
+            return mul_toom4_abs(a, a);
         }
-        else
+        if (n >= t.toom3)
         {
-            if (sign)
-            {
-                r.neg = true;
-            }
+            return mul_toom3_abs(a, a);
         }
-        *this = std::move(r);
-        return *this;
+        BigInt r;
+        if (n == 0)
+        {
+            return r;
+        }
+        uint64_t *ws = scratch_arena(kara_sqr_scratch(n));
+        r.d.resize(2u * n);
+        kara_sqr_n(r.d.data(), a.d.data(), n, ws);
+        r.neg = false;
+        r.trim();
+        return r;
     }
 
-    BigInt &BigInt::operator/=(const BigInt &rhs)
+    BigInt BigInt::sqr() const
     {
-        if (rhs.d.empty())
+        return sqr_abs(*this);
+    }
+
+    BigInt BigInt::mul_tiered_abs(const BigInt &a, const BigInt &b)
+    {
+        size_t n = a.d.size();
+        size_t m = b.d.size();
+        const Thresholds &t = thresholds();
+        if (n >= t.ntt && m >= t.ntt)
         {
-            throw std::domain_error("division by zero");
+            return mul_ntt_abs(a, b);
         }
-        BigInt qa;
-        BigInt ra;
-        BigInt aa = *this;
-        aa.neg = false;
-        BigInt bb = rhs;
-        bb.neg = false;
-        div_mod(aa, bb, qa, ra);
-        if (!qa.d.empty())
+
+        // Toom splits by the longer operand, which would leave the shorter one a single piece
+
+        if (n >= t.toom3 && m >= t.toom3 && (2u * n < m || 2u * m < n))
         {
-            qa.neg = neg != rhs.neg;
+            return mul_unbalanced_abs(a, b);
         }
-        else
+        if (n >= t.toom4 && m >= t.toom4)
         {
-            qa.neg = false;
+            return mul_toom4_abs(a, b);
         }
-        *this = std::move(qa);
-        return *this;
+        if (n >= t.toom3 && m >= t.toom3)
+        {
+            return mul_toom3_abs(a, b);
+        }
+        return mul_karatsuba_abs(a, b);
     }
 
-    BigInt operator+(BigInt lhs, const BigInt &rhs)
+    // longer operand cut into blocks the length of the shorter one, each a balanced product
+
+    BigInt BigInt::mul_unbalanced_abs(const BigInt &a, const BigInt &b)
     {
-        lhs += rhs;
-        return lhs;
+        const BigInt &x = a.d.size() >= b.d.size() ? a : b;
+        const BigInt &y = a.d.size() >= b.d.size() ? b : a;
+        size_t n = x.d.size();
+        size_t m = y.d.size();
+
+        BigInt r;
+        r.d.assign(n + m, 0u);
+        BigInt chunk;
+        size_t off = 0;
+        while (off < n)
+        {
+            size_t len = std::min(m, n - off);
+            chunk.d.assign(x.d.begin() + off, x.d.begin() + off + len);
+            chunk.trim();
+            BigInt p = mul_tiered_abs(chunk, y);
+            limb_add_in(r.d.data() + off, n + m - off, p.d.data(), p.d.size());
+            off += len;
+        }
+        r.neg = false;
+        r.trim();
+        return r;
     }
 
-    BigInt operator-(BigInt lhs, const BigInt &rhs)
+    // Toom-Cook
+
+    BigInt BigInt::mul_small(const BigInt &a, uint64_t m)
     {
-        lhs -= rhs;
-        return lhs;
+        BigInt r = a;
+        mul_small_add(r.d, m, 0u);
+        r.trim();
+        return r;
     }
 
-    BigInt operator*(BigInt lhs, const BigInt &rhs)
+    void BigInt::div_exact_small(BigInt &x, uint64_t m)
     {
-        lhs *= rhs;
-        return lhs;
+        div_small(x.d, m);
+        if (x.d.empty())
+        {
+            x.neg = false;
+        }
     }
 
-    BigInt operator/(BigInt lhs, const BigInt &rhs)
+    BigInt BigInt::mul_signed(const BigInt &a, const BigInt &b)
     {
-        lhs /= rhs;
-        return lhs;
+        BigInt r = mul_tiered_abs(a, b);
+        r.neg = (!r.d.empty() && a.neg != b.neg);
+        return r;
     }
 
-    bool operator==(const BigInt &a, const BigInt &b)
+    BigInt BigInt::mul_toom3_abs(const BigInt &a, const BigInt &b)
     {
-        if (a.neg != b.neg)
+        size_t n = a.d.size();
+        size_t m = b.d.size();
+        size_t k = ((n > m ? n : m) + 2) / 3;
+
+        BigInt a0, a1, a2, b0, b1, b2, t;
+        split_at(a, k, a0, t);
+        split_at(t, k, a1, a2);
+        split_at(b, k, b0, t);
+        split_at(t, k, b1, b2);
+
+        // evaluate at 0, 1, -1, -2, inf
+
+        BigInt pa = a0 + a2;
+        BigInt a_p1 = pa + a1;
+        BigInt a_m1 = pa - a1;
+        BigInt a_m2 = mul_small(a_m1 + a2, 2u) - a0;
+        BigInt pb = b0 + b2;
+        BigInt b_p1 = pb + b1;
+        BigInt b_m1 = pb - b1;
+        BigInt b_m2 = mul_small(b_m1 + b2, 2u) - b0;
+
+        // squaring: every pointwise product is a square as well
+
+        bool square = (&a == &b);
+        BigInt r0 = square ? sqr_abs(a0) : mul_tiered_abs(a0, b0);
+        BigInt r1 = square ? sqr_abs(a_p1) : mul_signed(a_p1, b_p1);
+        BigInt r_m1 = square ? sqr_abs(a_m1) : mul_signed(a_m1, b_m1);
+        BigInt r_m2 = square ? sqr_abs(a_m2) : mul_signed(a_m2, b_m2);
+        BigInt r_inf = square ? sqr_abs(a2) : mul_tiered_abs(a2, b2);
+
+        // interpolate, Bodrato's sequence
+
+        BigInt r3 = r_m2 - r1;
+        div_exact_small(r3, 3u);
+        r1 -= r_m1;
+        div_exact_small(r1, 2u);
+        BigInt r2 = r_m1 - r0;
+        r3 = r2 - r3;
+        div_exact_small(r3, 2u);
+        r3 += mul_small(r_inf, 2u);
+        r2 += r1;
+        r2 -= r_inf;
+        r1 -= r3;
+
+        BigInt r = add_abs(r0, shift_base_abs(r1, k));
+        r = add_abs(r, shift_base_abs(r2, 2u * k));
+        r = add_abs(r, shift_base_abs(r3, 3u * k));
+        r = add_abs(r, shift_base_abs(r_inf, 4u * k));
+        return r;
+    }
+
+    BigInt BigInt::mul_toom4_abs(const BigInt &a, const BigInt &b)
+    {
+        size_t n = a.d.size();
+        size_t m = b.d.size();
+        size_t k = ((n > m ? n : m) + 3) / 4;
+
+        BigInt a0, a1, a2, a3, b0, b1, b2, b3, t, u;
+        split_at(a, k, a0, t);
+        split_at(t, k, a1, u);
+        split_at(u, k, a2, a3);
+        split_at(b, k, b0, t);
+        split_at(t, k, b1, u);
+        split_at(u, k, b2, b3);
+
+        // evaluate at 0, 1, -1, 2, -2, 3, inf
+
+        BigInt ea1 = a0 + a2;
+        BigInt oa1 = a1 + a3;
+        BigInt ea2 = a0 + mul_small(a2, 4u);
+        BigInt oa2 = mul_small(a1, 2u) + mul_small(a3, 8u);
+        BigInt a3x = mul_small(mul_small(mul_small(a3, 3u) + a2, 3u) + a1, 3u) + a0;
+        BigInt eb1 = b0 + b2;
+        BigInt ob1 = b1 + b3;
+        BigInt eb2 = b0 + mul_small(b2, 4u);
+        BigInt ob2 = mul_small(b1, 2u) + mul_small(b3, 8u);
+        BigInt b3x = mul_small(mul_small(mul_small(b3, 3u) + b2, 3u) + b1, 3u) + b0;
+
+        // squaring: every pointwise product is a square as well
+
+        bool square = (&a == &b);
+        BigInt c0 = square ? sqr_abs(a0) : mul_tiered_abs(a0, b0);
+        BigInt r_p1 = square ? sqr_abs(ea1 + oa1) : mul_tiered_abs(ea1 + oa1, eb1 + ob1);
+        BigInt r_m1 = square ? sqr_abs(ea1 - oa1) : mul_signed(ea1 - oa1, eb1 - ob1);
+        BigInt r_p2 = square ? sqr_abs(ea2 + oa2) : mul_tiered_abs(ea2 + oa2, eb2 + ob2);
+        BigInt r_m2 = square ? sqr_abs(ea2 - oa2) : mul_signed(ea2 - oa2, eb2 - ob2);
+        BigInt r_p3 = square ? sqr_abs(a3x) : mul_tiered_abs(a3x, b3x);
+        BigInt c6 = square ? sqr_abs(a3) : mul_tiered_abs(a3, b3);
+
+        // interpolate: split even and odd coefficients using the +-x pairs,
+        // then use the value at 3 for the last odd equation
+
+        BigInt e1 = r_p1 + r_m1;
+        div_exact_small(e1, 2u);
+        e1 -= c0;
+        e1 -= c6;
+        BigInt o1 = r_p1 - r_m1;
+        div_exact_small(o1, 2u);
+        BigInt e2 = r_p2 + r_m2;
+        div_exact_small(e2, 2u);
+        e2 -= c0;
+        e2 -= mul_small(c6, 64u);
+        BigInt o2 = r_p2 - r_m2;
+        div_exact_small(o2, 4u);
+
+        div_exact_small(e2, 4u);
+        BigInt c4 = e2 - e1;
+        div_exact_small(c4, 3u);
+        BigInt c2 = e1 - c4;
+
+        BigInt t3 = r_p3 - c0;
+        t3 -= mul_small(c2, 9u);
+        t3 -= mul_small(c4, 81u);
+        t3 -= mul_small(c6, 729u);
+        div_exact_small(t3, 3u);
+
+        BigInt p = o2 - o1;
+        div_exact_small(p, 3u);
+        BigInt q = t3 - o2;
+        div_exact_small(q, 5u);
+        BigInt c5 = q - p;
+        div_exact_small(c5, 8u);
+        BigInt c3 = p - mul_small(c5, 5u);
+        BigInt c1 = o1 - c3;
+        c1 -= c5;
+
+        BigInt r = add_abs(c0, shift_base_abs(c1, k));
+        r = add_abs(r, shift_base_abs(c2, 2u * k));
+        r = add_abs(r, shift_base_abs(c3, 3u * k));
+        r = add_abs(r, shift_base_abs(c4, 4u * k));
+        r = add_abs(r, shift_base_abs(c5, 5u * k));
+        r = add_abs(r, shift_base_abs(c6, 6u * k));
+        return r;
+    }
+
+    // NTT: three primes c * 2^50 + 1 below 2^62, CRT recombination (Garner)
+
+    struct NttPrime
+    {
+        uint64_t p;
+        uint64_t pinv;
+        uint64_t r2;
+        uint64_t g;
+    };
+
+    static uint64_t ntt_redc(u128 t, const NttPrime &P)
+    {
+        uint64_t m = static_cast<uint64_t>(t) * P.pinv;
+        uint64_t u = static_cast<uint64_t>((t + static_cast<u128>(m) * P.p) >> 64);
+        return u >= P.p ? u - P.p : u;
+    }
+
+    static uint64_t ntt_mul(uint64_t a, uint64_t b, const NttPrime &P)
+    {
+        return ntt_redc(static_cast<u128>(a) * b, P);
+    }
+
+    static uint64_t ntt_pow(uint64_t a, uint64_t e, const NttPrime &P)
+    {
+        uint64_t r = ntt_redc(P.r2, P);
+        while (e > 0)
         {
-            if (a.d.empty() && b.d.empty())
+            if ((e & 1u) != 0)
             {
-                return true;
+                r = ntt_mul(r, a, P);
             }
-            return false;
-        }
-        if (a.d.size() != b.d.size())
-        {
-            return false;
+            a = ntt_mul(a, a, P);
+            e >>= 1;
         }
-        size_t i = 0;
-        while (i < a.d.size())
+        return r;
+    }
+
+    static NttPrime ntt_make_prime(uint64_t p, uint64_t g)
+    {
+        NttPrime P;
+        P.p = p;
+        uint64_t inv = 1;
+        for (int i = 0; i < 6; ++i)
         {
-            if (a.d[i] != b.d[i])
-            {
-                return false;
-            }
-            i += 1;
+            inv *= 2u - p * inv;
         }
-        return true;
+        P.pinv = 0u - inv;
+        u128 r = (static_cast<u128>(1) << 64) % p;
+        P.r2 = static_cast<uint64_t>(r * r % p);
+        P.g = ntt_mul(g, P.r2, P);
+        return P;
     }
 
-    bool operator!=(const BigInt &a, const BigInt &b)
+    static const uint64_t NTT_P1 = 7881299347898369ull; // 7 * 2^50 + 1
+    static const uint64_t NTT_P2 = 30399297484750849ull; // 27 * 2^50 + 1
+    static const uint64_t NTT_P3 = 77687093572141057ull; // 69 * 2^50 + 1
+
+    // floor(p1 * p2 * p3 / 2^128), about 2^35.7: a coefficient sums at most min(n, m) limb
+    // products below 2^128 each, so up to this many terms it stays below p1 * p2 * p3 and
+    // Garner recovers it exactly
+
+    static constexpr uint64_t ntt_max_terms()
     {
-        return !(a == b);
+        u128 p12 = static_cast<u128>(NTT_P1) * NTT_P2;
+        u128 lo = static_cast<u128>(static_cast<uint64_t>(p12)) * NTT_P3;
+        u128 hi = static_cast<u128>(static_cast<uint64_t>(p12 >> 64)) * NTT_P3 + (lo >> 64);
+        return static_cast<uint64_t>(hi >> 64);
     }
 
-    bool operator<(const BigInt &a, const BigInt &b)
+    static_assert(ntt_max_terms() >> 35 == 1, "NTT primes no longer cover 2^35 limbs");
+
+    static const NttPrime *ntt_primes()
     {
-        if (a.neg != b.neg)
+        static const NttPrime primes[3] = {
+            ntt_make_prime(NTT_P1, 6u),
+            ntt_make_prime(NTT_P2, 11u),
+            ntt_make_prime(NTT_P3, 5u),
+        };
+        return primes;
+    }
+
+    static void ntt_transform(std::vector<uint64_t> &a, const NttPrime &P, bool invert)
+    {
+        size_t n = a.size();
+        size_t j = 0;
+        for (size_t i = 1; i < n; ++i)
         {
-            if (a.neg)
+            size_t bit = n >> 1;
+            while ((j & bit) != 0)
             {
-                return true;
+                j ^= bit;
+                bit >>= 1;
             }
-            else
+            j ^= bit;
+            if (i < j)
             {
-                return false;
+                std::swap(a[i], a[j]);
             }
         }
-        int c = BigInt::cmp_abs(a, b);
-        if (!a.neg)
+
+        std::vector<uint64_t> w(n / 2 + 1);
+        for (size_t len = 2; len <= n; len <<= 1)
         {
-            if (c < 0)
+            uint64_t wl = ntt_pow(P.g, (P.p - 1u) / len, P);
+            if (invert)
             {
-                return true;
+                wl = ntt_pow(wl, P.p - 2u, P);
             }
-            else
+            size_t half = len / 2;
+            w[0] = ntt_redc(P.r2, P);
+            for (size_t k = 1; k < half; ++k)
             {
-                return false;
+                w[k] = ntt_mul(w[k - 1], wl, P);
+            }
+            for (size_t i = 0; i < n; i += len)
+            {
+                for (size_t k = 0; k < half; ++k)
+                {
+                    uint64_t u = a[i + k];
+                    uint64_t v = ntt_mul(a[i + k + half], w[k], P);
+                    uint64_t s = u + v;
+                    a[i + k] = s >= P.p ? s - P.p : s;
+                    a[i + k + half] = u >= v ? u - v : u + P.p - v;
+                }
+            }
+        }
+
+        if (invert)
+        {
+            uint64_t ninv = ntt_pow(ntt_mul(n % P.p, P.r2, P), P.p - 2u, P);
+            for (size_t i = 0; i < n; ++i)
+            {
+                a[i] = ntt_mul(a[i], ninv, P);
+            }
+        }
+    }
+
+    // cyclic convolution of the limbs of a and b modulo P, plain (non-Montgomery) residues out
+
+    static void ntt_convolve(const LimbVec &a, const LimbVec &b, size_t sz,
+                             const NttPrime &P, std::vector<uint64_t> &out)
+    {
+        out.assign(sz, 0u);
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            out[i] = ntt_mul(a[i] % P.p, P.r2, P);
+        }
+        ntt_transform(out, P, false);
+        if (&a == &b)
+        {
+            for (size_t i = 0; i < sz; ++i)
+            {
+                out[i] = ntt_mul(out[i], out[i], P);
             }
         }
         else
         {
-            if (c > 0)
+            std::vector<uint64_t> fb(sz, 0u);
+            for (size_t i = 0; i < b.size(); ++i)
             {
-                return true;
+                fb[i] = ntt_mul(b[i] % P.p, P.r2, P);
             }
-            else
+            ntt_transform(fb, P, false);
+            for (size_t i = 0; i < sz; ++i)
             {
-                return false;
+                out[i] = ntt_mul(out[i], fb[i], P);
             }
         }
+        ntt_transform(out, P, true);
+        for (size_t i = 0; i < sz; ++i)
+        {
+            out[i] = ntt_redc(out[i], P);
+        }
     }
 
-    bool operator>(const BigInt &a, const BigInt &b)
+    BigInt BigInt::mul_ntt_abs(const BigInt &a, const BigInt &b)
     {
-        return b < a;
-    }
+        BigInt r;
+        size_t n = a.d.size();
+        size_t m = b.d.size();
+        if (n == 0 || m == 0)
+        {
+            return r;
+        }
+        if (std::min(n, m) > ntt_max_terms())
+        {
+            return mul_toom4_abs(a, b);
+        }
+        size_t len = n + m - 1;
+        size_t sz = 1;
+        while (sz < len)
+        {
+            sz <<= 1;
+        }
 
-    bool operator<=(const BigInt &a, const BigInt &b)
-    {
-        return !(b < a);
+        const NttPrime *P = ntt_primes();
+        std::vector<uint64_t> res[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            ntt_convolve(a.d, &a == &b ? a.d : b.d, sz, P[k], res[k]);
+        }
+
+        // Garner: x = x1 + p1 * x2 + p1 * p2 * x3, each coefficient < 2^128 * min(n, m) <= p1 * p2 * p3
+        // by the ntt_max_terms() check above
+
+        const uint64_t p1 = P[0].p;
+        const uint64_t p2 = P[1].p;
+        const uint64_t p3 = P[2].p;
+
+        // constants in Montgomery form so that ntt_mul(x, c) == x * c mod p
+
+        const uint64_t inv_p1_p2 = ntt_pow(ntt_mul(p1, P[1].r2, P[1]), p2 - 2u, P[1]);
+        const uint64_t p1_p3 = ntt_mul(p1 % p3, P[2].r2, P[2]);
+        const uint64_t p12_p3 = ntt_mul(p1_p3, ntt_mul(p2 % p3, P[2].r2, P[2]), P[2]);
+        const uint64_t inv_p12_p3 = ntt_pow(p12_p3, p3 - 2u, P[2]);
+        const u128 p12 = static_cast<u128>(p1) * p2;
+        const uint64_t p12_lo = static_cast<uint64_t>(p12);
+        const uint64_t p12_hi = static_cast<uint64_t>(p12 >> 64);
+
+        r.d.assign(n + m + 1, 0u);
+        uint64_t c0 = 0;
+        uint64_t c1 = 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            uint64_t x1 = res[0][i];
+            uint64_t d2 = res[1][i] >= x1 ? res[1][i] - x1 : res[1][i] + p2 - x1;
+            uint64_t x2 = ntt_mul(d2, inv_p1_p2, P[1]);
+            uint64_t y = ntt_mul(x2, p1_p3, P[2]) + x1;
+            y = y >= p3 ? y - p3 : y;
+            uint64_t d3 = res[2][i] >= y ? res[2][i] - y : res[2][i] + p3 - y;
+            uint64_t x3 = ntt_mul(d3, inv_p12_p3, P[2]);
+
+            u128 s = static_cast<u128>(p1) * x2 + x1;
+            uint64_t v0 = static_cast<uint64_t>(s);
+            uint64_t v1 = static_cast<uint64_t>(s >> 64);
+            uint64_t v2 = 0;
+            u128 t = static_cast<u128>(p12_lo) * x3;
+            u128 z = static_cast<u128>(v0) + static_cast<uint64_t>(t);
+            v0 = static_cast<uint64_t>(z);
+            z = static_cast<u128>(v1) + static_cast<uint64_t>(t >> 64) + static_cast<uint64_t>(z >> 64);
+            v1 = static_cast<uint64_t>(z);
+            v2 += static_cast<uint64_t>(z >> 64);
+            t = static_cast<u128>(p12_hi) * x3;
+            z = static_cast<u128>(v1) + static_cast<uint64_t>(t);
+            v1 = static_cast<uint64_t>(z);
+            v2 += static_cast<uint64_t>(z >> 64) + static_cast<uint64_t>(t >> 64);
+
+            z = static_cast<u128>(c0) + v0;
+            r.d[i] = static_cast<uint64_t>(z);
+            z = static_cast<u128>(c1) + v1 + static_cast<uint64_t>(z >> 64);
+            c0 = static_cast<uint64_t>(z);
+            c1 = v2 + static_cast<uint64_t>(z >> 64);
+        }
+        r.d[len] = c0;
+        r.d[len + 1] = c1;
+        r.neg = false;
+        r.trim();
+        return r;
     }
 
-    bool operator>=(const BigInt &a, const BigInt &b)
+    // Burnikel-Ziegler
+
+    void BigInt::div_2n1n(const BigInt &a, const BigInt &b, size_t n, BigInt &q, BigInt &r)
     {
-        return !(a < b);
+        if (n % 2 != 0 || n < thresholds().burnikel_ziegler)
+        {
+            div_mod_schoolbook(a, b, q, r);
+            return;
+        }
+        size_t half = n / 2;
+
+        BigInt a_lo, a_hi;
+        split_at(a, half, a_lo, a_hi);
+
+        BigInt q1, r1;
+        div_3n2n(a_hi, b, half, q1, r1);
+
+        BigInt t = add_abs(shift_base_abs(r1, half), a_lo);
+        BigInt q2;
+        div_3n2n(t, b, half, q2, r);
+
+        q = add_abs(shift_base_abs(q1, half), q2);
     }
 
-    std::ostream &operator<<(std::ostream &os, const BigInt &v)
+    void BigInt::div_3n2n(const BigInt &a, const BigInt &b, size_t n, BigInt &q, BigInt &r)
     {
-        if (v.d.empty())
+        BigInt a3, a12, a2, a1;
+        split_at(a, n, a3, a12);
+        split_at(a12, n, a2, a1);
+        BigInt b2, b1;
+        split_at(b, n, b2, b1);
+
+        BigInt r1;
+        if (cmp_abs(a1, b1) < 0)
         {
-            os << "0";
-            return os;
+            div_2n1n(a12, b1, n, q, r1);
         }
-        if (v.neg)
+        else
         {
-            os << "-";
+            // a1 == b1: the quotient is 2^(64n) - 1 or a bit less
+
+            q.d.assign(n, std::numeric_limits<uint64_t>::max());
+            q.neg = false;
+            r1 = add_abs(sub_abs(a12, shift_base_abs(b1, n)), b1);
         }
-        os << v.d.back();
-        size_t i = v.d.size();
-        while (i > 1)
+
+        BigInt dd = mul_tiered_abs(q, b2);
+        BigInt rh = add_abs(shift_base_abs(r1, n), a3);
+        BigInt one(1);
+        while (cmp_abs(rh, dd) < 0)
         {
-            uint32_t block = v.d[i - 2];
-            os << std::setw(BigInt::BASE_DIGS) << std::setfill('0') << block;
-            i -= 1;
+            rh = add_abs(rh, b);
+            q = sub_abs(q, one);
         }
-        return os;
+        r = sub_abs(rh, dd);
     }
 
-    std::istream &operator>>(std::istream &is, BigInt &v)
+    void BigInt::div_mod_bz(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
     {
-        std::string s;
-        if (!(is >> s))
+        // pad the divisor to n = j * 2^k limbs with j below the threshold,
+        // so that every recursion level splits evenly
+
+        size_t s = b.d.size();
+        size_t j = s;
+        size_t k = 0;
+        size_t bz = thresholds().burnikel_ziegler;
+        while (j >= bz)
         {
-            return is;
+            j = (j + 1) / 2;
+            k += 1;
         }
-        v = BigInt::from_string(s);
-        return is;
-    }
+        size_t n = j << k;
+        size_t shift = n - s;
 
+        BigInt f;
+        f.d.assign(1, uint64_t(1) << std::countl_zero(b.d.back()));
+        BigInt bn = shift_base_abs(mul_abs(b, f), shift);
+        BigInt an = shift_base_abs(mul_abs(a, f), shift);
+
+        // t blocks of n limbs, the top one strictly below the divisor
+
+        size_t t = (an.d.size() + n) / n;
+        if (t < 2)
+        {
+            t = 2;
+        }
+
+        BigInt rest, z;
+        split_at(an, (t - 2) * n, rest, z);
+
+        BigInt acc;
+        BigInt qi, ri;
+        size_t i = t - 1;
+        while (i > 0)
+        {
+            i -= 1;
+            div_2n1n(z, bn, n, qi, ri);
+            acc = add_abs(shift_base_abs(acc, n), qi);
+            if (i > 0)
+            {
+                BigInt lo, blk;
+                split_at(rest, (i - 1) * n, lo, blk);
+                rest = std::move(lo);
+                z = add_abs(shift_base_abs(ri, n), blk);
+            }
+        }
+
+        BigInt low, high, unused;
+        split_at(ri, shift, low, high);
+        div_mod_schoolbook(high, f, r, unused);
+        q = std::move(acc);
+        q.neg = false;
+        r.neg = false;
+    }
 }
@@ -0,0 +1,178 @@
+#include <span>
+#include <stdexcept>
+
+#include "fixed_base.hpp"
+#include "mod_exp.hpp"
+
+namespace core
+{
+
+    static const size_t MAX_WINDOW = 16;
+
+    // bytes held by a table of w-bit windows over `bits` bits of k-limb residues
+    static size_t table_bytes(size_t bits, size_t w, size_t k)
+    {
+        size_t windows = (bits + w - 1) / w;
+        size_t digits = (size_t(1) << w) - 1u;
+        return windows * digits * (k * sizeof(uint64_t) + sizeof(std::vector<uint64_t>));
+    }
+
+    // bits [pos, pos + w) of |e|, w <= 64
+    static size_t window_digit(std::span<const uint64_t> e, size_t pos, size_t w)
+    {
+        size_t limb = pos / 64u;
+        size_t shift = pos % 64u;
+        if (limb >= e.size())
+        {
+            return 0;
+        }
+        uint64_t x = e[limb] >> shift;
+        if (shift + w > 64u && limb + 1 < e.size())
+        {
+            x |= e[limb + 1] << (64u - shift);
+        }
+        return static_cast<size_t>(x & ((uint64_t(1) << w) - 1u));
+    }
+
+    template <typename Context>
+    static void build_table(const Context &c, const BigInt &g, size_t bits, size_t w,
+                            std::vector<std::vector<uint64_t>> &table)
+    {
+        size_t windows = (bits + w - 1) / w;
+        size_t digits = (size_t(1) << w) - 1u;
+        table.assign(windows * digits, std::vector<uint64_t>());
+        std::vector<uint64_t> step;
+        c.to_residue(g, step);
+        size_t i = 0;
+        while (i < windows)
+        {
+            // step = g^(2^(w i)); row i is step^1 .. step^digits
+
+            std::vector<uint64_t> *row = &table[i * digits];
+            row[0] = step;
+            size_t v = 1;
+            while (v < digits)
+            {
+                c.mul(row[v], row[v - 1], step);
+                v += 1;
+            }
+            c.mul(step, row[digits - 1], step);
+            i += 1;
+        }
+    }
+
+    template <typename Context>
+    static BigInt table_pow(const Context &c, const std::vector<std::vector<uint64_t>> &table, size_t bits, size_t w,
+                            const BigInt &exp)
+    {
+        std::span<const uint64_t> e = exp.limbs();
+        size_t digits = (size_t(1) << w) - 1u;
+        std::vector<uint64_t> result;
+        bool started = false;
+        size_t i = 0;
+        while (i * w < bits)
+        {
+            size_t v = window_digit(e, i * w, w);
+            if (v != 0)
+            {
+                const std::vector<uint64_t> &entry = table[i * digits + v - 1];
+                if (started)
+                {
+                    c.mul(result, result, entry);
+                }
+                else
+                {
+                    result = entry;
+                    started = true;
+                }
+            }
+            i += 1;
+        }
+        if (!started)
+        {
+            c.one(result);
+        }
+        return c.from_residue(result);
+    }
+
+    FixedBaseExp::FixedBaseExp(const BigInt &base, const BigInt &mod, size_t max_bits, size_t memory_budget)
+        : g(base), m(mod), w(0), bits(max_bits == 0 ? 1 : max_bits), ctx(), table()
+    {
+        if (m.is_zero())
+        {
+            throw std::invalid_argument("mod is zero");
+        }
+        if (m.is_negative())
+        {
+            m = BigInt(0) - m;
+        }
+        if (m == BigInt(1))
+        {
+            return;
+        }
+
+        size_t k = m.limbs().size();
+        while (w < MAX_WINDOW && table_bytes(bits, w + 1, k) <= memory_budget)
+        {
+            w += 1;
+        }
+
+        // w == 0: not even one-bit windows fit, every pow goes through mod_exp
+
+        if (m.is_odd())
+        {
+            ctx.emplace<MontgomeryContext>(m);
+        }
+        else
+        {
+            ctx.emplace<BarrettContext>(m);
+        }
+        if (w == 0)
+        {
+            return;
+        }
+        if (const MontgomeryContext *c = std::get_if<MontgomeryContext>(&ctx))
+        {
+            build_table(*c, g, bits, w, table);
+        }
+        else
+        {
+            build_table(std::get<BarrettContext>(ctx), g, bits, w, table);
+        }
+    }
+
+    const BigInt &FixedBaseExp::modulus() const
+    {
+        return m;
+    }
+
+    size_t FixedBaseExp::window() const
+    {
+        return w;
+    }
+
+    size_t FixedBaseExp::max_bits() const
+    {
+        return bits;
+    }
+
+    BigInt FixedBaseExp::pow(const BigInt &exp) const
+    {
+        if (exp.is_negative())
+        {
+            throw std::invalid_argument("negative exponent");
+        }
+        if (std::holds_alternative<std::monostate>(ctx))
+        {
+            return BigInt(0);
+        }
+        bool wide = w == 0 || exp.bit_length() > bits;
+        if (const MontgomeryContext *c = std::get_if<MontgomeryContext>(&ctx))
+        {
+            return wide ? mod_exp(g, exp, *c) : table_pow(*c, table, bits, w, exp);
+        }
+        const BarrettContext &c = std::get<BarrettContext>(ctx);
+        return wide ? mod_exp(g, exp, c) : table_pow(c, table, bits, w, exp);
+    }
+
+}
@@ -1,15 +1,9 @@
 #include "mod_exp.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 namespace core
 {
-    static BigInt mod_reduce(const BigInt &a, const BigInt &m)
-    {
-        BigInt q = a / m;
-        BigInt r = a - q * m;
-        return r;
-    }
-
     static BigInt abs_big(const BigInt &x)
     {
         if (x < BigInt(0))
@@ -19,50 +13,300 @@ namespace core
         return x;
     }
 
-    static bool is_zero(const BigInt &x)
+    BigInt mod_exp(const BigInt &base, const BigInt &exp, const BigInt &mod)
     {
-        return x == BigInt(0);
+        if (mod.is_zero())
+        {
+            throw std::invalid_argument("mod is zero");
+        }
+
+        if (exp.is_negative())
+        {
+            throw std::invalid_argument("negative exponent");
+        }
+
+        BigInt m = abs_big(mod);
+        if (m == BigInt(1))
+        {
+            return BigInt(0);
+        }
+        if (m.is_odd())
+        {
+            MontgomeryContext ctx(m);
+            return mod_exp(base, exp, ctx);
+        }
+        BarrettContext ctx(m);
+        return mod_exp(base, exp, ctx);
     }
 
-    static bool is_odd(const BigInt &x)
+    // window width for a given exponent length, roughly minimizing
+    // 2^(w-1) table multiplies + bits / (w + 1) window multiplies
+    static size_t window_width(size_t bits)
     {
-        BigInt r = mod_reduce(x, BigInt(2));
-        return r == BigInt(1);
+        if (bits > 671)
+        {
+            return 6;
+        }
+        if (bits > 239)
+        {
+            return 5;
+        }
+        if (bits > 79)
+        {
+            return 4;
+        }
+        if (bits > 23)
+        {
+            return 3;
+        }
+        return 1;
     }
 
-    BigInt mod_exp(const BigInt &base, const BigInt &exp, const BigInt &mod)
+    // odd window value whose lowest bit sits at exponent bit `low`
+    struct ExpWindow
     {
-        if (mod == BigInt(0))
+        size_t low;
+        size_t value;
+    };
+
+    // left-to-right sliding windows of at most w bits, each ending in a one
+    static std::vector<ExpWindow> sliding_windows(const BigInt &exp, size_t w)
+    {
+        std::vector<ExpWindow> out;
+        size_t i = exp.bit_length();
+        while (i > 0)
         {
-            throw std::invalid_argument("mod is zero");
+            if (!exp.test_bit(i - 1))
+            {
+                i -= 1;
+                continue;
+            }
+
+            // longest window e[j .. i - 1] of at most w bits that ends in a one
+
+            size_t j = i > w ? i - w : 0;
+            while (!exp.test_bit(j))
+            {
+                j += 1;
+            }
+            size_t value = 0;
+            for (size_t b = i; b > j; --b)
+            {
+                value = (value << 1) | (exp.test_bit(b - 1) ? 1u : 0u);
+            }
+            out.push_back({j, value});
+            i = j;
         }
+        return out;
+    }
 
-        if (exp < BigInt(0))
+    // residues of the odd powers a, a^3, ..., a^(2^w - 1)
+    template <typename Context>
+    static void odd_powers(const Context &ctx, const BigInt &a, size_t w, std::vector<std::vector<uint64_t>> &table)
+    {
+        table.assign(size_t(1) << (w - 1), std::vector<uint64_t>());
+        ctx.to_residue(a, table[0]);
+        if (table.size() > 1)
         {
-            throw std::invalid_argument("negative exponent");
+            std::vector<uint64_t> a2;
+            ctx.sqr(a2, table[0]);
+            for (size_t t = 1; t < table.size(); ++t)
+            {
+                ctx.mul(table[t], table[t - 1], a2);
+            }
         }
+    }
 
-        BigInt m = abs_big(mod);
-        BigInt a = mod_reduce(base, m);
-        if (a < BigInt(0))
+    // Straus interleaving: one squaring chain shared by all bases, each base multiplies
+    // in from its own odd-power table where one of its sliding windows ends
+
+    template <typename Context>
+    static BigInt multi_exp_ctx(const BigInt *bases, const BigInt *exps, size_t count, const Context &ctx)
+    {
+        std::vector<std::vector<ExpWindow>> windows(count);
+        std::vector<std::vector<std::vector<uint64_t>>> tables(count);
+        size_t bits = 0;
+        for (size_t j = 0; j < count; ++j)
+        {
+            if (exps[j].is_negative())
+            {
+                throw std::invalid_argument("negative exponent");
+            }
+            size_t b = exps[j].bit_length();
+            if (b == 0)
+            {
+                continue;
+            }
+            size_t w = window_width(b);
+            windows[j] = sliding_windows(exps[j], w);
+            odd_powers(ctx, bases[j], w, tables[j]);
+            bits = std::max(bits, b);
+        }
+
+        std::vector<uint64_t> result;
+        ctx.one(result);
+        std::vector<size_t> next(count, 0);
+        bool started = false;
+        size_t i = bits;
+        while (i > 0)
         {
-            a = a + m;
+            i -= 1;
+            if (started)
+            {
+                ctx.sqr(result, result);
+            }
+            for (size_t j = 0; j < count; ++j)
+            {
+                if (next[j] == windows[j].size() || windows[j][next[j]].low != i)
+                {
+                    continue;
+                }
+                const std::vector<uint64_t> &entry = tables[j][windows[j][next[j]].value >> 1];
+                if (started)
+                {
+                    ctx.mul(result, result, entry);
+                }
+                else
+                {
+                    result = entry;
+                    started = true;
+                }
+                next[j] += 1;
+            }
         }
 
-        BigInt e = exp;
-        BigInt result(1);
+        return ctx.from_residue(result);
+    }
 
-        while (!is_zero(e))
+    template <typename Context>
+    static BigInt mod_exp_ctx(const BigInt &base, const BigInt &exp, const Context &ctx)
+    {
+        return multi_exp_ctx(&base, &exp, 1, ctx);
+    }
+
+    BigInt mod_exp(const BigInt &base, const BigInt &exp, const MontgomeryContext &ctx)
+    {
+        return mod_exp_ctx(base, exp, ctx);
+    }
+
+    BigInt mod_exp(const BigInt &base, const BigInt &exp, const BarrettContext &ctx)
+    {
+        return mod_exp_ctx(base, exp, ctx);
+    }
+
+    BigInt mod_multi_exp(std::span<const BigInt> bases, std::span<const BigInt> exps, const BigInt &mod)
+    {
+        if (bases.size() != exps.size())
+        {
+            throw std::invalid_argument("bases and exponents differ in length");
+        }
+        if (mod.is_zero())
         {
-            if (is_odd(e))
+            throw std::invalid_argument("mod is zero");
+        }
+        for (const BigInt &e : exps)
+        {
+            if (e.is_negative())
             {
-                result = mod_reduce(result * a, m);
+                throw std::invalid_argument("negative exponent");
             }
+        }
+
+        BigInt m = abs_big(mod);
+        if (m == BigInt(1))
+        {
+            return BigInt(0);
+        }
+        if (m.is_odd())
+        {
+            MontgomeryContext ctx(m);
+            return mod_multi_exp(bases, exps, ctx);
+        }
+        BarrettContext ctx(m);
+        return mod_multi_exp(bases, exps, ctx);
+    }
+
+    BigInt mod_multi_exp(std::span<const BigInt> bases, std::span<const BigInt> exps, const MontgomeryContext &ctx)
+    {
+        if (bases.size() != exps.size())
+        {
+            throw std::invalid_argument("bases and exponents differ in length");
+        }
+        return multi_exp_ctx(bases.data(), exps.data(), bases.size(), ctx);
+    }
+
+    BigInt mod_multi_exp(std::span<const BigInt> bases, std::span<const BigInt> exps, const BarrettContext &ctx)
+    {
+        if (bases.size() != exps.size())
+        {
+            throw std::invalid_argument("bases and exponents differ in length");
+        }
+        return multi_exp_ctx(bases.data(), exps.data(), bases.size(), ctx);
+    }
+
+    // swap a and b when mask is all ones, leave them when it is zero
+    static void cswap(std::vector<uint64_t> &a, std::vector<uint64_t> &b, uint64_t mask)
+    {
+        size_t i = 0;
+        while (i < a.size())
+        {
+            uint64_t x = (a[i] ^ b[i]) & mask;
+            a[i] ^= x;
+            b[i] ^= x;
+            i += 1;
+        }
+    }
 
-            a = mod_reduce(a * a, m);
-            e = e / BigInt(2);
+    BigInt mod_exp_ct(const BigInt &base, const BigInt &exp, const BigInt &mod)
+    {
+        if (mod.is_zero())
+        {
+            throw std::invalid_argument("mod is zero");
+        }
+        if (exp.is_negative())
+        {
+            throw std::invalid_argument("negative exponent");
+        }
+        BigInt m = abs_big(mod);
+        if (m == BigInt(1))
+        {
+            return BigInt(0);
+        }
+        MontgomeryContext ctx(m);
+        return mod_exp_ct(base, exp, ctx);
+    }
+
+    // invariant r1 = r0 * base; each step maps (r0, r1) to (r0^2, r0 r1) or (r0 r1, r1^2),
+    // the second case done as the first between two swaps
+
+    BigInt mod_exp_ct(const BigInt &base, const BigInt &exp, const MontgomeryContext &ctx)
+    {
+        if (exp.is_negative())
+        {
+            throw std::invalid_argument("negative exponent");
+        }
+
+        std::vector<uint64_t> e(exp.limbs().begin(), exp.limbs().end());
+        e.resize(std::max(e.size(), ctx.width()), 0u);
+
+        std::vector<uint64_t> r0;
+        std::vector<uint64_t> r1;
+        ctx.one(r0);
+        ctx.to_residue(base, r1);
+
+        uint64_t swapped = 0;
+        size_t i = e.size() * 64u;
+        while (i > 0)
+        {
+            uint64_t bit = (e[(i - 1) / 64u] >> ((i - 1) % 64u)) & 1u;
+            cswap(r0, r1, 0u - (swapped ^ bit));
+            swapped = bit;
+            ctx.mul(r1, r0, r1);
+            ctx.sqr(r0, r0);
+            i -= 1;
         }
+        cswap(r0, r1, 0u - swapped);
 
-        return result;
+        return ctx.from_residue(r0);
     }
 }
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <variant>
+
+#include "mod_exp.hpp"
+
+namespace core
+{
+
+    using BatchContext = std::variant<std::monostate, MontgomeryContext, BarrettContext>;
+
+    // context for |mod|, monostate for |mod| == 1 where every power is 0
+    static BatchContext make_context(const BigInt &mod)
+    {
+        if (mod.is_zero())
+        {
+            throw std::invalid_argument("mod is zero");
+        }
+        BigInt m = mod;
+        if (m.is_negative())
+        {
+            m = BigInt(0) - m;
+        }
+        if (m == BigInt(1))
+        {
+            return BatchContext();
+        }
+        if (m.is_odd())
+        {
+            return BatchContext(std::in_place_type<MontgomeryContext>, m);
+        }
+        return BatchContext(std::in_place_type<BarrettContext>, m);
+    }
+
+    static BigInt batch_item(const BigInt &base, const BigInt &exp, const BatchContext &ctx)
+    {
+        if (const MontgomeryContext *c = std::get_if<MontgomeryContext>(&ctx))
+        {
+            return mod_exp(base, exp, *c);
+        }
+        if (const BarrettContext *c = std::get_if<BarrettContext>(&ctx))
+        {
+            return mod_exp(base, exp, *c);
+        }
+        return BigInt(0);
+    }
+
+    // out[i] = bases[i]^exps[i] under ctxs[which[i]]; threads claim one index at a time
+    // from a shared cursor, so the load balances itself when item costs differ
+    static void run_batch(std::span<const BigInt> bases, std::span<const BigInt> exps,
+                          const std::vector<BatchContext> &ctxs, const std::vector<size_t> &which,
+                          std::vector<BigInt> &out, size_t threads)
+    {
+        size_t count = bases.size();
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        if (threads == 0 || threads > cores)
+        {
+            threads = cores;
+        }
+        threads = std::min(threads, count);
+
+        std::atomic<size_t> cursor(0);
+        std::exception_ptr error;
+        std::mutex error_lock;
+        auto worker = [&]()
+        {
+            try
+            {
+                size_t i = cursor.fetch_add(1, std::memory_order_relaxed);
+                while (i < count)
+                {
+                    out[i] = batch_item(bases[i], exps[i], ctxs[which[i]]);
+                    i = cursor.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                cursor.store(count, std::memory_order_relaxed);
+            }
+        };
+
+        if (threads <= 1)
+        {
+            worker();
+        }
+        else
+        {
+            // a thread that fails to start leaves the work to the ones already running; the
+            // pool must not be destroyed while it holds joinable threads
+
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            try
+            {
+                for (size_t t = 1; t < threads; ++t)
+                {
+                    pool.emplace_back(worker);
+                }
+            }
+            catch (const std::system_error &)
+            {
+            }
+            worker();
+            for (std::thread &t : pool)
+            {
+                t.join();
+            }
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    static void check_batch(std::span<const BigInt> bases, std::span<const BigInt> exps)
+    {
+        if (bases.size() != exps.size())
+        {
+            throw std::invalid_argument("bases and exponents differ in length");
+        }
+        for (const BigInt &e : exps)
+        {
+            if (e.is_negative())
+            {
+                throw std::invalid_argument("negative exponent");
+            }
+        }
+    }
+
+    std::vector<BigInt> mod_exp_batch(std::span<const BigInt> bases, std::span<const BigInt> exps,
+                                      const BigInt &mod, size_t threads)
+    {
+        check_batch(bases, exps);
+        std::vector<BatchContext> ctxs;
+        ctxs.push_back(make_context(mod));
+        std::vector<size_t> which(bases.size(), 0);
+        std::vector<BigInt> out(bases.size());
+        run_batch(bases, exps, ctxs, which, out, threads);
+        return out;
+    }
+
+    std::vector<BigInt> mod_exp_batch(std::span<const BigInt> bases, std::span<const BigInt> exps,
+                                      std::span<const BigInt> mods, size_t threads)
+    {
+        check_batch(bases, exps);
+        if (mods.size() != bases.size())
+        {
+            throw std::invalid_argument("bases and moduli differ in length");
+        }
+
+        // one context per distinct |mod|
+
+        std::map<BigInt, size_t> index;
+        std::vector<BatchContext> ctxs;
+        std::vector<size_t> which(bases.size());
+        for (size_t i = 0; i < mods.size(); ++i)
+        {
+            BigInt m = mods[i].is_negative() ? BigInt(0) - mods[i] : mods[i];
+            auto it = index.find(m);
+            if (it == index.end())
+            {
+                ctxs.push_back(make_context(m));
+                it = index.emplace(m, ctxs.size() - 1).first;
+            }
+            which[i] = it->second;
+        }
+        std::vector<BigInt> out(bases.size());
+        run_batch(bases, exps, ctxs, which, out, threads);
+        return out;
+    }
+
+}
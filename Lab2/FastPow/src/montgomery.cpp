@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "montgomery.hpp"
+#include "residue_arith.hpp"
+
+namespace core
+{
+
+    // 2k + 2 limbs of scratch per thread for the double-width product
+    static uint64_t *product_scratch(size_t k)
+    {
+        static thread_local std::vector<uint64_t> t;
+        if (t.size() < 2u * k + 2u)
+        {
+            t.resize(2u * k + 2u);
+        }
+        return t.data();
+    }
+
+    MontgomeryContext::MontgomeryContext(const BigInt &mod) : m(mod), n(), k(0), n_inv(0), r1(), r2()
+    {
+        if (m.is_negative() || !m.is_odd() || m == BigInt(1))
+        {
+            throw std::invalid_argument("montgomery modulus must be odd and greater than one");
+        }
+        n.assign(m.limbs().begin(), m.limbs().end());
+        k = n.size();
+
+        // -m^-1 mod 2^64 by Newton iteration, each step doubles the correct low bits
+
+        uint64_t inv = 1;
+        for (int i = 0; i < 6; ++i)
+        {
+            inv *= 2u - n[0] * inv;
+        }
+        n_inv = 0u - inv;
+
+        std::vector<uint64_t> pow_r(k + 1, 0u);
+        pow_r[k] = 1u;
+        r1 = reduce_mod(BigInt::from_limbs(pow_r), m, k);
+        std::vector<uint64_t> pow_r2(2u * k + 1, 0u);
+        pow_r2[2u * k] = 1u;
+        r2 = reduce_mod(BigInt::from_limbs(pow_r2), m, k);
+    }
+
+    const BigInt &MontgomeryContext::modulus() const
+    {
+        return m;
+    }
+
+    size_t MontgomeryContext::width() const
+    {
+        return k;
+    }
+
+    // r = t * R^-1 mod m for t < m * R held in t[0 .. 2k], word-by-word REDC.
+    // No branches or early exits depend on t, so mul / sqr run in fixed time for a given k.
+    void MontgomeryContext::redc(std::vector<uint64_t> &r, uint64_t *t) const
+    {
+        uint64_t top = 0;
+        size_t i = 0;
+        while (i < k)
+        {
+            uint64_t q = t[i] * n_inv;
+            uint64_t carry = 0;
+            size_t j = 0;
+            while (j < k)
+            {
+                u128 cur = static_cast<u128>(q) * n[j] + t[i + j] + carry;
+                t[i + j] = static_cast<uint64_t>(cur);
+                carry = static_cast<uint64_t>(cur >> 64);
+                j += 1;
+            }
+
+            // the carry out of t[i + k] is deferred to the next row instead of rippling up
+
+            u128 cur = static_cast<u128>(t[i + k]) + carry + top;
+            t[i + k] = static_cast<uint64_t>(cur);
+            top = static_cast<uint64_t>(cur >> 64);
+            i += 1;
+        }
+
+        // result is top:t[k .. 2k) < 2m, subtract m and keep the difference unless it borrowed
+
+        const uint64_t *u = t + k;
+        r.resize(k);
+        uint64_t borrow = 0;
+        size_t j = 0;
+        while (j < k)
+        {
+            u128 cur = static_cast<u128>(u[j]) - n[j] - borrow;
+            r[j] = static_cast<uint64_t>(cur);
+            borrow = static_cast<uint64_t>(cur >> 64) & 1u;
+            j += 1;
+        }
+        uint64_t keep = 0u - static_cast<uint64_t>(top >= borrow);
+        j = 0;
+        while (j < k)
+        {
+            r[j] = (r[j] & keep) | (u[j] & ~keep);
+            j += 1;
+        }
+    }
+
+    void MontgomeryContext::mul(std::vector<uint64_t> &r, const std::vector<uint64_t> &a,
+                                 const std::vector<uint64_t> &b) const
+    {
+        uint64_t *t = product_scratch(k);
+        mul_wide(t, a.data(), b.data(), k);
+        t[2u * k] = 0u;
+        redc(r, t);
+    }
+
+    void MontgomeryContext::sqr(std::vector<uint64_t> &r, const std::vector<uint64_t> &a) const
+    {
+        uint64_t *t = product_scratch(k);
+        sqr_wide(t, a.data(), k);
+        t[2u * k] = 0u;
+        redc(r, t);
+    }
+
+    void MontgomeryContext::to_residue(const BigInt &a, std::vector<uint64_t> &out) const
+    {
+        std::vector<uint64_t> x = reduce_mod(a, m, k);
+        mul(out, x, r2);
+    }
+
+    BigInt MontgomeryContext::from_residue(const std::vector<uint64_t> &a) const
+    {
+        uint64_t *t = product_scratch(k);
+        std::fill(t, t + 2u * k + 1u, 0u);
+        std::copy(a.begin(), a.end(), t);
+        std::vector<uint64_t> r;
+        redc(r, t);
+        return BigInt::from_limbs(std::move(r));
+    }
+
+    void MontgomeryContext::one(std::vector<uint64_t> &out) const
+    {
+        out = r1;
+    }
+
+    BigInt MontgomeryContext::mul(const BigInt &a, const BigInt &b) const
+    {
+        std::vector<uint64_t> x;
+        std::vector<uint64_t> y;
+        to_residue(a, x);
+        to_residue(b, y);
+        mul(x, x, y);
+        return from_residue(x);
+    }
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bigint.hpp"
+
+// Limb arithmetic shared by MontgomeryContext and BarrettContext; each context only adds its
+// own reduction of the double-width result.
+
+namespace core
+{
+
+    __extension__ typedef unsigned __int128 u128;
+
+    namespace
+    {
+        // limbs of a mod m in [0, m), zero padded to k
+        std::vector<uint64_t> reduce_mod(const BigInt &a, const BigInt &m, size_t k)
+        {
+            BigInt r = a;
+            r.submul(a / m, m);
+            if (r < BigInt(0))
+            {
+                r += m;
+            }
+            std::span<const uint64_t> l = r.limbs();
+            std::vector<uint64_t> out(l.begin(), l.end());
+            out.resize(k, 0u);
+            return out;
+        }
+
+        // t[0 .. 2k) = a * b for k-limb a and b, schoolbook
+        void mul_wide(uint64_t *t, const uint64_t *a, const uint64_t *b, size_t k)
+        {
+            std::fill(t, t + 2u * k, 0u);
+            size_t i = 0;
+            while (i < k)
+            {
+                uint64_t carry = 0;
+                uint64_t ai = a[i];
+                size_t j = 0;
+                while (j < k)
+                {
+                    u128 cur = static_cast<u128>(ai) * b[j] + t[i + j] + carry;
+                    t[i + j] = static_cast<uint64_t>(cur);
+                    carry = static_cast<uint64_t>(cur >> 64);
+                    j += 1;
+                }
+                t[i + k] = carry;
+                i += 1;
+            }
+        }
+
+        // t[0 .. 2k) = a^2 for a k-limb a
+        void sqr_wide(uint64_t *t, const uint64_t *a, size_t k)
+        {
+            std::fill(t, t + 2u * k, 0u);
+
+            // cross products once, doubled, plus the diagonal
+
+            size_t i = 0;
+            while (i < k)
+            {
+                uint64_t carry = 0;
+                uint64_t ai = a[i];
+                size_t j = i + 1;
+                while (j < k)
+                {
+                    u128 cur = static_cast<u128>(ai) * a[j] + t[i + j] + carry;
+                    t[i + j] = static_cast<uint64_t>(cur);
+                    carry = static_cast<uint64_t>(cur >> 64);
+                    j += 1;
+                }
+                t[i + k] = carry;
+                i += 1;
+            }
+            uint64_t top = 0;
+            i = 0;
+            while (i < 2u * k)
+            {
+                uint64_t x = t[i];
+                t[i] = (x << 1) | top;
+                top = x >> 63;
+                i += 1;
+            }
+            uint64_t carry = 0;
+            i = 0;
+            while (i < k)
+            {
+                u128 sq = static_cast<u128>(a[i]) * a[i];
+                u128 s = static_cast<u128>(t[2u * i]) + static_cast<uint64_t>(sq) + carry;
+                t[2u * i] = static_cast<uint64_t>(s);
+                s = static_cast<u128>(t[2u * i + 1u]) + static_cast<uint64_t>(sq >> 64) + static_cast<uint64_t>(s >> 64);
+                t[2u * i + 1u] = static_cast<uint64_t>(s);
+                carry = static_cast<uint64_t>(s >> 64);
+                i += 1;
+            }
+        }
+    }
+
+}
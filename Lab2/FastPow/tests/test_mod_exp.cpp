@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "bigint.hpp"
+#include "fixed_base.hpp"
 #include "mod_exp.hpp"
 
 using core::BigInt;
@@ -118,3 +119,242 @@ TEST(ModExpRandom, CrossCheckMedium)
     BigInt mod("10007");
     EXPECT_EQ(mod_exp(base, exp, mod), slow_pow_mod(base, exp, mod));
 }
+
+static BigInt ref_pow_mod(BigInt b, BigInt e, const BigInt &m)
+{
+    b = mod_reduce(b, m);
+    if (b < BigInt(0))
+    {
+        b = b + m;
+    }
+    BigInt res(1);
+    while (e > BigInt(0))
+    {
+        BigInt half = e / BigInt(2);
+        if (e - half * BigInt(2) == BigInt(1))
+        {
+            res = mod_reduce(res * b, m);
+        }
+        b = mod_reduce(b * b, m);
+        e = half;
+    }
+    return mod_reduce(res, m);
+}
+
+TEST(Montgomery, RejectsEvenOrTrivialModulus)
+{
+    EXPECT_THROW(core::MontgomeryContext(BigInt(10)), std::invalid_argument);
+    EXPECT_THROW(core::MontgomeryContext(BigInt(1)), std::invalid_argument);
+    EXPECT_THROW(core::MontgomeryContext(BigInt(-7)), std::invalid_argument);
+}
+
+TEST(Montgomery, RoundTripAndMul)
+{
+    BigInt m("340282366920938463463374607431768211507");
+    core::MontgomeryContext ctx(m);
+    EXPECT_EQ(ctx.width(), 3u);
+    BigInt a("123456789012345678901234567890123456789");
+    BigInt b("-98765432109876543210987654321");
+    std::vector<uint64_t> x;
+    ctx.to_residue(a, x);
+    EXPECT_EQ(ctx.from_residue(x), mod_reduce(a, m));
+    BigInt p = mod_reduce(a * b, m);
+    if (p < BigInt(0))
+    {
+        p = p + m;
+    }
+    EXPECT_EQ(ctx.mul(a, b), p);
+}
+
+TEST(Montgomery, ContextReuseMatchesReference)
+{
+    BigInt m("179769313486231590772930519078902473361797697894230657273430081157732675805500963132708477322407536021120113879871393357658789768814416622492847430639474124377767893424865485276302219601246094119453082952085005768838150682342462881473913110540827237163350510684586298239947245938479716304835356329624224137859");
+    core::MontgomeryContext ctx(m);
+    BigInt b("2");
+    for (int i = 0; i < 4; ++i)
+    {
+        BigInt e("65537");
+        e = e * BigInt(1000003 + i) + BigInt(i);
+        EXPECT_EQ(mod_exp(b, e, ctx), ref_pow_mod(b, e, m));
+        EXPECT_EQ(mod_exp(b, e, m), ref_pow_mod(b, e, m));
+        b = b * BigInt(3) + BigInt(1);
+    }
+}
+
+TEST(Barrett, RejectsTrivialModulus)
+{
+    EXPECT_THROW(core::BarrettContext(BigInt(1)), std::invalid_argument);
+    EXPECT_THROW(core::BarrettContext(BigInt(0)), std::invalid_argument);
+}
+
+TEST(Barrett, EvenModuliMatchReference)
+{
+    BigInt two64("18446744073709551616");
+    for (const BigInt &m : {BigInt(10), two64, two64 * two64 * BigInt(6),
+                            BigInt("1000000000000000000000000000000000000000000000000000000000000000000000")})
+    {
+        core::BarrettContext ctx(m);
+        BigInt a("98765432109876543210987654321098765432109876543210");
+        BigInt b("-1234567890123456789012345678901234567890");
+        BigInt p = mod_reduce(a * b, m);
+        if (p < BigInt(0))
+        {
+            p = p + m;
+        }
+        EXPECT_EQ(ctx.mul(a, b), p);
+        BigInt e("1000000007");
+        EXPECT_EQ(mod_exp(a, e, ctx), ref_pow_mod(a, e, m));
+        EXPECT_EQ(mod_exp(a, e, m), ref_pow_mod(a, e, m));
+    }
+}
+
+TEST(SlidingWindow, ExponentShapesAcrossWindowWidths)
+{
+    BigInt m("340282366920938463463374607431768211507");
+    BigInt b("123456789012345678901234567890");
+    BigInt two(2);
+    for (int bits : {1, 23, 24, 80, 240, 672, 700})
+    {
+        BigInt p(1);
+        for (int i = 0; i < bits; ++i)
+        {
+            p = p * two;
+        }
+        // 2^bits, 2^bits - 1 (all ones) and a sparse 2^bits + 1
+        for (const BigInt &e : {p, p - BigInt(1), p + BigInt(1)})
+        {
+            EXPECT_EQ(mod_exp(b, e, m), ref_pow_mod(b, e, m));
+            EXPECT_EQ(mod_exp(b, e, m * two), ref_pow_mod(b, e, m * two));
+        }
+    }
+}
+
+TEST(ConstantTime, LadderMatchesWindowedExp)
+{
+    BigInt m("179769313486231590772930519078902473361797697894230657273430081157732675805500963132708477322407536021120113879871393357658789768814416622492847430639474124377767893424865485276302219601246094119453082952085005768838150682342462881473913110540827237163350510684586298239947245938479716304835356329624224137859");
+    core::MontgomeryContext ctx(m);
+    BigInt b("-98765432109876543210987654321");
+    BigInt big = m * m + BigInt(12345);
+    for (const BigInt &e : {BigInt(0), BigInt(1), BigInt(2), BigInt(65537), m - BigInt(2), big})
+    {
+        EXPECT_EQ(core::mod_exp_ct(b, e, ctx), mod_exp(b, e, m));
+        EXPECT_EQ(core::mod_exp_ct(b, e, BigInt(0) - m), mod_exp(b, e, m));
+    }
+    EXPECT_EQ(core::mod_exp_ct(BigInt(3), BigInt(200), BigInt(7)), ref_pow_mod(BigInt(3), BigInt(200), BigInt(7)));
+    EXPECT_EQ(core::mod_exp_ct(b, BigInt(65537), BigInt(1)), BigInt(0));
+    EXPECT_EQ(core::mod_exp_ct(b, BigInt(0), BigInt(-1)), BigInt(0));
+}
+
+TEST(ConstantTime, RejectsEvenModulusAndNegativeExponent)
+{
+    EXPECT_THROW(core::mod_exp_ct(BigInt(3), BigInt(5), BigInt(10)), std::invalid_argument);
+    EXPECT_THROW(core::mod_exp_ct(BigInt(3), BigInt(-5), BigInt(11)), std::invalid_argument);
+    try
+    {
+        core::mod_exp_ct(BigInt(3), BigInt(5), BigInt(0));
+        ADD_FAILURE() << "zero modulus accepted";
+    }
+    catch (const std::invalid_argument &e)
+    {
+        EXPECT_STREQ(e.what(), "mod is zero");
+    }
+}
+
+TEST(MultiExp, MatchesProductOfPowers)
+{
+    BigInt two64("18446744073709551616");
+    BigInt odd("340282366920938463463374607431768211507");
+    std::vector<BigInt> bases = {BigInt("123456789012345678901234567890"), BigInt(-7), BigInt(2),
+                                 BigInt("98765432109876543210"), BigInt(0)};
+    std::vector<BigInt> exps = {BigInt("1000000000000000000000000000007"), BigInt(65537), BigInt(0),
+                                odd * odd, BigInt(3)};
+    for (const BigInt &m : {odd, odd * two64, BigInt(97), BigInt(1)})
+    {
+        for (size_t count = 0; count <= bases.size(); ++count)
+        {
+            BigInt expected = mod_reduce(BigInt(1), m);
+            for (size_t i = 0; i < count; ++i)
+            {
+                expected = mod_reduce(expected * mod_exp(bases[i], exps[i], m), m);
+            }
+            std::span<const BigInt> b(bases.data(), count);
+            std::span<const BigInt> e(exps.data(), count);
+            EXPECT_EQ(core::mod_multi_exp(b, e, m), expected);
+        }
+    }
+    core::MontgomeryContext ctx(odd);
+    EXPECT_EQ(core::mod_multi_exp(std::span<const BigInt>(bases.data(), 2), std::span<const BigInt>(exps.data(), 2), ctx),
+              mod_reduce(mod_exp(bases[0], exps[0], odd) * mod_exp(bases[1], exps[1], odd), odd));
+}
+
+TEST(MultiExp, RejectsBadInput)
+{
+    std::vector<BigInt> bases = {BigInt(2), BigInt(3)};
+    std::vector<BigInt> exps = {BigInt(5)};
+    EXPECT_THROW(core::mod_multi_exp(bases, exps, BigInt(11)), std::invalid_argument);
+    exps.push_back(BigInt(-1));
+    EXPECT_THROW(core::mod_multi_exp(bases, exps, BigInt(11)), std::invalid_argument);
+    exps[1] = BigInt(1);
+    EXPECT_THROW(core::mod_multi_exp(bases, exps, BigInt(0)), std::invalid_argument);
+}
+
+TEST(FixedBase, MatchesModExp)
+{
+    BigInt two64("18446744073709551616");
+    BigInt odd("340282366920938463463374607431768211507");
+    BigInt g("-123456789012345678901234567890");
+    for (const BigInt &m : {odd, odd * two64, BigInt(-97), BigInt(1)})
+    {
+        for (size_t budget : {size_t(0), size_t(1) << 14, core::FixedBaseExp::DEFAULT_MEMORY_BUDGET})
+        {
+            core::FixedBaseExp fb(g, m, 200, budget);
+            EXPECT_EQ(fb.window() == 0, budget == 0 || m == BigInt(1));
+            for (const BigInt &e : {BigInt(0), BigInt(1), BigInt(65537), odd, odd * odd, odd * odd * odd})
+            {
+                EXPECT_EQ(fb.pow(e), mod_exp(g, e, m));
+            }
+        }
+    }
+    EXPECT_EQ(core::FixedBaseExp(g, odd, 1000000, 0).window(), 0u);
+    EXPECT_THROW(core::FixedBaseExp(g, BigInt(0), 64), std::invalid_argument);
+    EXPECT_THROW(core::FixedBaseExp(g, odd, 64).pow(BigInt(-1)), std::invalid_argument);
+}
+
+TEST(Batch, MatchesSerialInInputOrder)
+{
+    BigInt odd("340282366920938463463374607431768211507");
+    BigInt even = odd * BigInt(6);
+    std::vector<BigInt> bases, exps, mods;
+    for (int i = 0; i < 40; ++i)
+    {
+        bases.push_back(BigInt("123456789012345678901234567890") * BigInt(i + 1) - BigInt(1000));
+        exps.push_back(BigInt("1000000000000000000000000000007") + BigInt(i * 7919));
+        mods.push_back(i % 3 == 0 ? odd : (i % 3 == 1 ? BigInt(0) - even : BigInt(1)));
+    }
+    for (size_t threads : {size_t(0), size_t(1), size_t(3), size_t(64)})
+    {
+        std::vector<BigInt> one_mod = core::mod_exp_batch(bases, exps, odd, threads);
+        std::vector<BigInt> per_item = core::mod_exp_batch(bases, exps, mods, threads);
+        ASSERT_EQ(one_mod.size(), bases.size());
+        ASSERT_EQ(per_item.size(), bases.size());
+        for (size_t i = 0; i < bases.size(); ++i)
+        {
+            EXPECT_EQ(one_mod[i], mod_exp(bases[i], exps[i], odd));
+            EXPECT_EQ(per_item[i], mod_exp(bases[i], exps[i], mods[i]));
+        }
+    }
+    EXPECT_TRUE(core::mod_exp_batch(std::span<const BigInt>(), std::span<const BigInt>(), odd).empty());
+}
+
+TEST(Batch, RejectsBadInput)
+{
+    std::vector<BigInt> bases = {BigInt(2), BigInt(3)};
+    std::vector<BigInt> exps = {BigInt(5), BigInt(-1)};
+    std::vector<BigInt> mods = {BigInt(7), BigInt(0)};
+    EXPECT_THROW(core::mod_exp_batch(bases, exps, BigInt(11)), std::invalid_argument);
+    exps[1] = BigInt(1);
+    EXPECT_THROW(core::mod_exp_batch(bases, exps, BigInt(0)), std::invalid_argument);
+    EXPECT_THROW(core::mod_exp_batch(bases, exps, mods), std::invalid_argument);
+    mods.pop_back();
+    EXPECT_THROW(core::mod_exp_batch(bases, exps, mods), std::invalid_argument);
+}
@@ -183,3 +183,550 @@ TEST_F(Fx, RandomKaratsubaProperty)
         EXPECT_EQ(r.to_string(), b.to_string());
     }
 }
+
+TEST_F(Fx, DivRandomQuotientRemainder)
+{
+    for (int t = 0; t < 40; t++)
+    {
+        BigInt a(num(20 + static_cast<size_t>(rng() % 400)));
+        BigInt b(num(1 + static_cast<size_t>(rng() % 200)));
+        BigInt q = a / b;
+        BigInt r = a - q * b;
+        EXPECT_TRUE(r >= BigInt(0));
+        EXPECT_TRUE(r < b);
+    }
+}
+
+TEST_F(Fx, DivQuotientDigitCorrection)
+{
+    BigInt a("999999999999999999000000000000000000");
+    BigInt b("999999999000000001");
+    BigInt q = a / b;
+    BigInt r = a - q * b;
+    EXPECT_TRUE(r >= BigInt(0));
+    EXPECT_TRUE(r < b);
+    BigInt c("1000000000000000000000000000");
+    BigInt e("500000000000000001");
+    EXPECT_EQ((c / e).to_string(), "1999999999");
+}
+
+TEST_F(Fx, DivBurnikelZieglerLarge)
+{
+    for (int t = 0; t < 6; t++)
+    {
+        BigInt b(num(700 + static_cast<size_t>(rng() % 1500)));
+        BigInt q0(num(600 + static_cast<size_t>(rng() % 2500)));
+        BigInt r0 = b - BigInt(1 + t);
+        BigInt a = q0 * b + r0;
+        EXPECT_EQ((a / b).to_string(), q0.to_string());
+        EXPECT_EQ(((a - r0) / b).to_string(), q0.to_string());
+    }
+}
+
+TEST_F(Fx, BinaryLimbBoundaries)
+{
+    BigInt two64("18446744073709551616");
+    BigInt max64("18446744073709551615");
+    EXPECT_EQ((max64 + BigInt(1)).to_string(), two64.to_string());
+    EXPECT_EQ((two64 - BigInt(1)).to_string(), max64.to_string());
+    EXPECT_EQ((max64 * max64).to_string(), "340282366920938463426481119284349108225");
+    EXPECT_EQ((two64 * two64 / max64).to_string(), "18446744073709551617");
+    BigInt dec("10000000000000000000000000000000000000000");
+    EXPECT_EQ(dec.to_string(), "10000000000000000000000000000000000000000");
+    EXPECT_EQ((dec - BigInt(1)).to_string(), std::string(40, '9'));
+}
+
+TEST_F(Fx, AddMixedSignsKeepsSign)
+{
+    EXPECT_EQ((BigInt(-436305458) + BigInt(9)).to_string(), "-436305449");
+    EXPECT_EQ((BigInt(9) + BigInt(-436305458)).to_string(), "-436305449");
+    EXPECT_EQ((BigInt(436305458) + BigInt(-9)).to_string(), "436305449");
+    EXPECT_EQ((BigInt(-9) + BigInt(9)).to_string(), "0");
+}
+
+TEST_F(Fx, ToomTiersMatchDivision)
+{
+    for (int t = 0; t < 4; t++)
+    {
+        std::string s1 = num(4500 + static_cast<size_t>(rng() % 2000));
+        std::string s2 = num(4500 + static_cast<size_t>(rng() % 2000));
+        BigInt a(s1), b(s2);
+        BigInt p = a * b;
+        EXPECT_EQ((p / a).to_string(), b.to_string());
+        EXPECT_EQ((p / b).to_string(), a.to_string());
+    }
+    BigInt big(num(13000));
+    BigInt neg = BigInt(0) - big;
+    EXPECT_EQ((neg * big).to_string(), (BigInt(0) - big * big).to_string());
+}
+
+TEST_F(Fx, NttMatchesToomSplit)
+{
+    std::string hi = num(40000);
+    std::string lo = num(40000);
+    BigInt a(hi + lo);
+    BigInt b(num(60000));
+    BigInt a_hi(hi), a_lo(lo);
+    BigInt p = a * b;
+    BigInt q = a_hi * b * BigInt("1" + std::string(40000, '0')) + a_lo * b;
+    EXPECT_EQ(p, q);
+    BigInt s = a * a;
+    EXPECT_EQ(s / a, a);
+}
+
+TEST_F(Fx, KaratsubaUnbalancedChunks)
+{
+    for (int t = 0; t < 6; t++)
+    {
+        std::string s1 = num(700 + static_cast<size_t>(rng() % 3000));
+        std::string s2 = num(620 + static_cast<size_t>(rng() % 200));
+        BigInt a(s1), b(s2);
+        BigInt p = a * b;
+        EXPECT_EQ(p / b, a);
+        EXPECT_EQ(b * a, p);
+    }
+}
+
+TEST_F(Fx, SqrMatchesMul)
+{
+    for (size_t digits : {1u, 19u, 20u, 700u, 1000u, 5000u, 13000u, 50000u})
+    {
+        BigInt a(num(digits));
+        BigInt b = a;
+        EXPECT_EQ(a.sqr(), a * b);
+        BigInt n = BigInt(0) - a;
+        EXPECT_EQ(n.sqr(), a * b);
+        BigInt c = a;
+        c *= c;
+        EXPECT_EQ(c, a * b);
+    }
+    EXPECT_EQ(BigInt(0).sqr(), BigInt(0));
+}
+
+TEST_F(Fx, BitPrimitivesMatchArithmetic)
+{
+    EXPECT_TRUE(BigInt(0).is_zero());
+    EXPECT_FALSE(BigInt(0).is_odd());
+    EXPECT_EQ(BigInt(0).bit_length(), 0u);
+    EXPECT_EQ(BigInt(1).bit_length(), 1u);
+    EXPECT_EQ(BigInt("18446744073709551616").bit_length(), 65u);
+    EXPECT_TRUE(BigInt(-7).is_odd());
+    EXPECT_TRUE(BigInt("18446744073709551616").test_bit(64));
+    EXPECT_FALSE(BigInt("18446744073709551616").test_bit(63));
+    EXPECT_FALSE(BigInt(5).test_bit(1000));
+
+    for (int t = 0; t < 20; t++)
+    {
+        BigInt a(num(1 + static_cast<size_t>(rng() % 400)));
+        size_t k = static_cast<size_t>(rng() % 300);
+        BigInt p(1);
+        for (size_t i = 0; i < k; i++)
+        {
+            p = p * BigInt(2);
+        }
+        EXPECT_EQ(a << k, a * p);
+        EXPECT_EQ(a >> k, a / p);
+        BigInt n = BigInt(0) - a;
+        EXPECT_EQ(n >> k, n / p);
+        BigInt s = a;
+        s <<= k;
+        s >>= k;
+        EXPECT_EQ(s, a);
+        EXPECT_EQ(a.test_bit(k), (a / p).is_odd());
+        EXPECT_EQ((a << k).bit_length(), a.bit_length() + k);
+    }
+    EXPECT_EQ(BigInt(-1) >> 1, BigInt(0));
+}
+
+TEST_F(Fx, DivmodSmall)
+{
+    for (int t = 0; t < 20; t++)
+    {
+        BigInt a(num(1 + static_cast<size_t>(rng() % 500)));
+        uint32_t m = static_cast<uint32_t>(rng() | 1u);
+        BigInt q = a;
+        uint32_t r = q.divmod_small(m);
+        EXPECT_EQ(q, a / BigInt(m));
+        EXPECT_EQ(q * BigInt(m) + BigInt(r), a);
+        BigInt n = BigInt(0) - a;
+        EXPECT_EQ(n.divmod_small(m), r);
+        EXPECT_EQ(n, BigInt(0) - q);
+    }
+    BigInt z(-3);
+    EXPECT_EQ(z.divmod_small(5), 3u);
+    EXPECT_EQ(z.to_string(), "0");
+    EXPECT_THROW(z.divmod_small(0), std::domain_error);
+}
+
+TEST_F(Fx, DecimalConversionDivideAndConquer)
+{
+    for (size_t digits : {569u, 570u, 571u, 1216u, 2433u, 9728u, 9729u, 40000u})
+    {
+        std::string s = num(digits);
+        BigInt a(s);
+        EXPECT_EQ(a.to_string(), s);
+        EXPECT_EQ((BigInt(0) - a).to_string(), "-" + s);
+        EXPECT_EQ(BigInt("-000" + s), BigInt(0) - a);
+
+        // 10^(digits - 1) built by multiplication, printed with its run of zeros
+
+        BigInt p(1);
+        BigInt ten(10);
+        for (size_t i = 1; i < digits; i++)
+            p = p * ten;
+        std::string p10(digits, '0');
+        p10[0] = '1';
+        EXPECT_EQ(p.to_string(), p10);
+        EXPECT_EQ(BigInt(p10), p);
+        EXPECT_EQ((p - BigInt(1)).to_string(), std::string(digits - 1, '9'));
+    }
+}
+
+TEST_F(Fx, ToCharsAndDecimalSize)
+{
+    EXPECT_EQ(BigInt(0).decimal_size(), 1u);
+    EXPECT_EQ(BigInt(-7).decimal_size(), 2u);
+    char small[4];
+    std::to_chars_result r = BigInt(-123).to_chars(small, small + 4);
+    EXPECT_EQ(r.ec, std::errc());
+    EXPECT_EQ(std::string(small, r.ptr), "-123");
+    r = BigInt(-1234).to_chars(small, small + 4);
+    EXPECT_EQ(r.ec, std::errc::value_too_large);
+    EXPECT_EQ(r.ptr, small + 4);
+
+    for (size_t digits : {1u, 18u, 19u, 20u, 38u, 39u, 570u, 571u, 600u, 5000u, 12345u})
+    {
+        for (const std::string &s : {num(digits), std::string(digits, '9'), "1" + std::string(digits - 1, '0')})
+        {
+            for (const std::string &t : {s, "-" + s})
+            {
+                BigInt a(t);
+                ASSERT_EQ(a.decimal_size(), t.size());
+                std::vector<char> buf(t.size() + 3, '#');
+                r = a.to_chars(buf.data(), buf.data() + buf.size());
+                EXPECT_EQ(r.ec, std::errc());
+                EXPECT_EQ(std::string(buf.data(), r.ptr), t);
+                r = a.to_chars(buf.data(), buf.data() + t.size());
+                EXPECT_EQ(std::string(buf.data(), r.ptr), t);
+                r = a.to_chars(buf.data(), buf.data() + t.size() - 1);
+                EXPECT_EQ(r.ec, std::errc::value_too_large);
+                std::ostringstream os;
+                os << a;
+                EXPECT_EQ(os.str(), t);
+            }
+        }
+    }
+}
+
+TEST_F(Fx, FromCharsParsesInPlace)
+{
+    BigInt v(42);
+    std::string bad[] = {"", "-", "+5", " 5", "x12", "-a"};
+    for (const std::string &s : bad)
+    {
+        std::from_chars_result r = core::from_chars(s.data(), s.data() + s.size(), v);
+        EXPECT_EQ(r.ec, std::errc::invalid_argument);
+        EXPECT_EQ(r.ptr, s.data());
+        EXPECT_EQ(v, BigInt(42));
+    }
+
+    std::string s = "-000123456789012345678901234567890,rest";
+    std::from_chars_result r = core::from_chars(s.data(), s.data() + s.size(), v);
+    EXPECT_EQ(r.ec, std::errc());
+    EXPECT_EQ(r.ptr, s.data() + s.find(','));
+    EXPECT_EQ(v, BigInt("-123456789012345678901234567890"));
+
+    r = core::from_chars(s.data() + 1, s.data() + 8, v);
+    EXPECT_EQ(r.ptr, s.data() + 8);
+    EXPECT_EQ(v, BigInt(1234));
+    std::string z = "-0000000000";
+    core::from_chars(z.data(), z.data() + z.size(), v);
+    EXPECT_EQ(v.to_string(), "0");
+
+    // every length mod 8 / mod 19, digit runs ending on each non-digit neighbour of '0'..'9'
+
+    for (size_t digits = 1; digits < 60; digits++)
+    {
+        std::string d = num(digits);
+        for (char stop : {'/', ':', ' ', '\0'})
+        {
+            std::string t = d + stop + "99999999";
+            r = core::from_chars(t.data(), t.data() + t.size(), v);
+            EXPECT_EQ(r.ptr, t.data() + digits);
+            EXPECT_EQ(v.to_string(), d);
+        }
+    }
+    std::string big = num(30000);
+    r = core::from_chars(big.data(), big.data() + big.size(), v);
+    EXPECT_EQ(r.ptr, big.data() + big.size());
+    EXPECT_EQ(v.to_string(), big);
+}
+
+TEST_F(Fx, InlineLimbStorageCopyAndMove)
+{
+    // 0..5 limbs: inline up to two, heap beyond; every assignment direction between them
+
+    std::vector<BigInt> vals;
+    BigInt x(1);
+    BigInt base("18446744073709551616");
+    for (int i = 0; i < 6; i++)
+    {
+        vals.push_back(i == 0 ? BigInt(0) : BigInt(0) - x);
+        x = x * base + BigInt(i);
+    }
+    for (const BigInt &a : vals)
+    {
+        for (const BigInt &b : vals)
+        {
+            BigInt c = a;
+            c = b;
+            EXPECT_EQ(c, b);
+            BigInt m = a;
+            BigInt src = b;
+            m = std::move(src);
+            EXPECT_EQ(m, b);
+            src = a;
+            EXPECT_EQ(src, a);
+            BigInt moved(std::move(m));
+            EXPECT_EQ(moved, b);
+            moved += a;
+            EXPECT_EQ(moved - a, b);
+        }
+        BigInt self = a;
+        BigInt &alias = self;
+        self = alias;
+        EXPECT_EQ(self, a);
+        EXPECT_EQ(BigInt::from_limbs(std::vector<uint64_t>(a.limbs().begin(), a.limbs().end()), a.is_negative()), a);
+    }
+}
+
+TEST_F(Fx, FusedMulAccumulate)
+{
+    // every sign combination, sizes on both sides of the Karatsuba threshold, and aliasing
+
+    const size_t sizes[] = {0, 1, 19, 40, 200, 700, 1500};
+    for (size_t sa : sizes)
+    {
+        for (size_t sb : sizes)
+        {
+            for (int signs = 0; signs < 8; signs++)
+            {
+                BigInt a(num(sa));
+                BigInt b(num(sb));
+                BigInt c(num((sa + sb) / 2 + 1));
+                if (signs & 1)
+                    a = BigInt(0) - a;
+                if (signs & 2)
+                    b = BigInt(0) - b;
+                if (signs & 4)
+                    c = BigInt(0) - c;
+
+                BigInt x = c;
+                x.addmul(a, b);
+                EXPECT_EQ(x, c + a * b);
+                BigInt y = c;
+                y.submul(a, b);
+                EXPECT_EQ(y, c - a * b);
+                EXPECT_EQ(core::fma(a, b, c), a * b + c);
+            }
+        }
+    }
+
+    BigInt a(num(60));
+    BigInt p = a * a;
+    BigInt x = p;
+    x.submul(a, a);
+    EXPECT_EQ(x, BigInt(0));
+    EXPECT_FALSE(x.is_negative());
+    x = a;
+    x.addmul(x, x);
+    EXPECT_EQ(x, a + p);
+    x = a;
+    x.submul(x, a);
+    EXPECT_EQ(x, a - p);
+}
+
+TEST_F(Fx, MulIntoAliasingAndBufferReuse)
+{
+    // every tier, with dest distinct from, equal to one of, or equal to both operands
+
+    const size_t sizes[] = {1, 30, 700, 4500, 14000, 50000};
+    for (size_t sa : sizes)
+    {
+        for (size_t sb : sizes)
+        {
+            BigInt a(num(sa));
+            BigInt b = BigInt(0) - BigInt(num(sb));
+            BigInt expect = a * b;
+
+            BigInt dest(num(5));
+            core::mul_into(dest, a, b);
+            EXPECT_EQ(dest, expect);
+            BigInt x = a;
+            core::mul_into(x, x, b);
+            EXPECT_EQ(x, expect);
+            BigInt y = b;
+            core::mul_into(y, a, y);
+            EXPECT_EQ(y, expect);
+            BigInt z = a;
+            z *= b;
+            EXPECT_EQ(z, expect);
+            BigInt s = a;
+            core::mul_into(s, s, s);
+            EXPECT_EQ(s, a * BigInt(a));
+            s = b;
+            s *= s;
+            EXPECT_EQ(s, b * BigInt(b));
+        }
+    }
+
+    // a destination that already has room keeps its buffer
+
+    BigInt a(num(300));
+    BigInt b(num(300));
+    BigInt dest = a * b * a;
+    const uint64_t *before = dest.limbs().data();
+    core::mul_into(dest, a, b);
+    EXPECT_EQ(dest.limbs().data(), before);
+    EXPECT_EQ(dest, a * b);
+    core::mul_into(dest, a, BigInt(0));
+    EXPECT_EQ(dest, BigInt(0));
+    EXPECT_FALSE(dest.is_negative());
+}
+
+TEST_F(Fx, CarryChainsAcrossVectorBlocks)
+{
+    // runs of all-ones / zero limbs make carries and borrows ripple through whole blocks
+
+    for (size_t n : {1u, 3u, 4u, 7u, 8u, 9u, 15u, 16u, 17u, 64u, 101u})
+    {
+        BigInt top = BigInt(1) << (64u * n);
+        BigInt ones = top - BigInt(1);
+        EXPECT_EQ(ones + BigInt(1), top);
+        EXPECT_EQ(top - ones, BigInt(1));
+        EXPECT_EQ(BigInt(1) - top, BigInt(0) - ones);
+        EXPECT_EQ(ones + ones, (top << 1) - BigInt(2));
+
+        for (int t = 0; t < 20; t++)
+        {
+            std::vector<uint64_t> la(n);
+            std::vector<uint64_t> lb(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                uint64_t r = rng();
+                la[i] = (r & 3u) == 0 ? ~0ull : ((r & 3u) == 1 ? 0u : rng());
+                lb[i] = (r & 12u) == 0 ? ~la[i] : ((r & 12u) == 4 ? la[i] : rng());
+            }
+            BigInt a = BigInt::from_limbs(la, false);
+            BigInt b = BigInt::from_limbs(lb, false);
+            BigInt s = a + b;
+            EXPECT_EQ(s - b, a);
+            EXPECT_EQ(s - a, b);
+            EXPECT_EQ((a - b) + b, a);
+            BigInt x = a;
+            x += b;
+            x -= a;
+            EXPECT_EQ(x, b);
+        }
+    }
+}
+
+TEST_F(Fx, BaseCaseProductsAcrossSizes)
+{
+    // every size through the vector base case and its chunked form for long operands,
+    // checked against a split at a limb boundary and against squaring
+
+    auto limbs = [&](size_t n) {
+        std::vector<uint64_t> v(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t r = rng();
+            v[i] = (r & 3u) == 0 ? ~0ull : rng();
+        }
+        v[n - 1] |= 1u;
+        return BigInt::from_limbs(v, false);
+    };
+    for (size_t n = 1; n <= 100; n++)
+    {
+        BigInt a = limbs(n);
+        BigInt b = limbs(1 + rng() % 100);
+        BigInt lo = limbs(n);
+        BigInt p = a * b;
+        EXPECT_EQ(((a << 640) + lo) * b, (p << 640) + lo * b);
+        EXPECT_EQ(a.sqr(), a * BigInt(a));
+        EXPECT_EQ(p / b, a);
+    }
+    for (size_t n : {97u, 150u, 300u})
+    {
+        BigInt a = limbs(n);
+        BigInt b = limbs(20 + rng() % 76);
+        BigInt p = a * b;
+        EXPECT_EQ(p / b, a);
+        EXPECT_EQ((p + BigInt(1)) / b, a);
+    }
+}
+
+TEST_F(Fx, ThresholdsOverrideKeepsResults)
+{
+    // tiny thresholds push every algorithm, down to NTT, onto operands of a few dozen limbs
+
+    const BigInt::Thresholds saved = BigInt::thresholds();
+    std::vector<BigInt> xs;
+    for (size_t digits : {30u, 200u, 700u, 1500u, 3000u})
+    {
+        xs.push_back(BigInt(num(digits)));
+        xs.push_back(BigInt(0) - BigInt(num(digits + 37)));
+    }
+    std::vector<std::string> expect;
+    for (const BigInt &a : xs)
+    {
+        for (const BigInt &b : xs)
+        {
+            expect.push_back((a * b).to_string());
+            expect.push_back((a * b / b).to_string());
+        }
+        expect.push_back(a.sqr().to_string());
+    }
+
+    BigInt::set_thresholds({4, 4, 8, 12, 40, 4});
+    EXPECT_EQ(BigInt::thresholds().ntt, 40u);
+    size_t i = 0;
+    for (const BigInt &a : xs)
+    {
+        for (const BigInt &b : xs)
+        {
+            EXPECT_EQ((a * b).to_string(), expect[i++]);
+            EXPECT_EQ((a * b / b).to_string(), expect[i++]);
+        }
+        EXPECT_EQ(a.sqr().to_string(), expect[i++]);
+    }
+
+    EXPECT_THROW(BigInt::set_thresholds({3, 4, 8, 12, 40, 4}), std::invalid_argument);
+    EXPECT_THROW(BigInt::set_thresholds({4, 4, 8, 12, 40, 1}), std::invalid_argument);
+    EXPECT_EQ(BigInt::thresholds().karatsuba, 4u);
+    BigInt::set_thresholds(saved);
+    EXPECT_EQ(BigInt::thresholds().karatsuba, BigInt::default_thresholds().karatsuba);
+    EXPECT_NE(std::string(BigInt::kernel_set()), std::string());
+}
+
+TEST_F(Fx, UnbalancedProductsAboveToomThreshold)
+{
+    // the longer operand is cut into blocks of the shorter one's length, the last one short
+
+    const BigInt::Thresholds saved = BigInt::thresholds();
+    const size_t never = std::numeric_limits<size_t>::max();
+    for (size_t shorter : {180u, 700u, 1300u})
+    {
+        BigInt a(num(shorter));
+        BigInt b(BigInt(0) - BigInt(num(4000)));
+        BigInt::set_thresholds({4, 4, never, never, never, 4});
+        BigInt expect = a * b;
+        BigInt::set_thresholds({4, 4, 8, 12, never, 4});
+        EXPECT_EQ(a * b, expect);
+        EXPECT_EQ(b * a, expect);
+        BigInt r;
+        core::mul_into(r, b, a);
+        EXPECT_EQ(r, expect);
+    }
+    BigInt::set_thresholds(saved);
+}
@@ -0,0 +1,319 @@
+// bigint_tune: measures where each multiplication, squaring and division algorithm starts
+// to beat the one below it on this machine and writes the crossovers as bigint_tuned.hpp,
+// which bigint.cpp picks up the next time it is compiled
+//
+//   bigint_tune [-o path] [--max-limbs n]    (n >= 8, default 131072)
+
+#include "bigint.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+using core::BigInt;
+
+namespace
+{
+    const size_t NEVER = std::numeric_limits<size_t>::max();
+
+    enum class Op
+    {
+        Mul,
+        Sqr,
+        Div
+    };
+
+    const char *op_name(Op op)
+    {
+        switch (op)
+        {
+        case Op::Mul:
+            return "mul";
+        case Op::Sqr:
+            return "sqr";
+        default:
+            return "div";
+        }
+    }
+
+    BigInt random_limbs(std::mt19937_64 &rng, size_t n)
+    {
+        std::vector<uint64_t> v(n);
+        for (uint64_t &x : v)
+        {
+            x = rng();
+        }
+        v[n - 1] |= uint64_t(1) << 63;
+        return BigInt::from_limbs(std::move(v), false);
+    }
+
+    // seconds per call over one sample, repeated until the sample spans two milliseconds
+
+    double sample(const std::function<void()> &f, size_t &reps)
+    {
+        typedef std::chrono::steady_clock Clock;
+        while (true)
+        {
+            Clock::time_point t0 = Clock::now();
+            for (size_t i = 0; i < reps; ++i)
+            {
+                f();
+            }
+            double s = std::chrono::duration<double>(Clock::now() - t0).count();
+            if (s >= 2e-3 || reps >= (size_t(1) << 20))
+            {
+                return s / static_cast<double>(reps);
+            }
+            reps *= 2;
+        }
+    }
+
+    struct Timing
+    {
+        double without;
+        double with;
+    };
+
+    // best of seven for both configurations, sampled alternately so that drift in the
+    // machine's speed hits them alike
+
+    Timing compare(Op op, size_t n, const BigInt::Thresholds &without, const BigInt::Thresholds &with)
+    {
+        std::mt19937_64 rng(n);
+        BigInt a = random_limbs(rng, op == Op::Div ? 2u * n : n);
+        BigInt b = random_limbs(rng, n);
+        BigInt r;
+        std::function<void()> f;
+        switch (op)
+        {
+        case Op::Mul:
+            f = [&] { core::mul_into(r, a, b); };
+            break;
+        case Op::Sqr:
+            f = [&] { core::mul_into(r, a, a); };
+            break;
+        default:
+            f = [&] { r = a / b; };
+            break;
+        }
+
+        Timing t = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+        size_t reps_without = 1;
+        size_t reps_with = 1;
+        BigInt::set_thresholds(without);
+        f();
+        BigInt::set_thresholds(with);
+        f();
+        for (int i = 0; i < 7; ++i)
+        {
+            BigInt::set_thresholds(without);
+            t.without = std::min(t.without, sample(f, reps_without));
+            BigInt::set_thresholds(with);
+            t.with = std::min(t.with, sample(f, reps_with));
+        }
+        return t;
+    }
+
+    typedef std::function<BigInt::Thresholds(size_t n, bool use)> Config;
+
+    bool wins(const char *mark, Op op, size_t n, const Config &config)
+    {
+        Timing t = compare(op, n, config(n, false), config(n, true));
+        bool win = t.with < t.without;
+        std::printf("  %s %8zu limbs  %12.3f us  %12.3f us%s\n", mark, n, t.without * 1e6, t.with * 1e6,
+                    win ? "  *" : "");
+        std::fflush(stdout);
+        return win;
+    }
+
+    // first size in [lo, hi] from which the algorithm, applied at the top level (use = true),
+    // beats leaving that level to the one below. Sizes grow by an eighth per step until two
+    // steps in a row win, then the step before the first win is rescanned finely. Returns
+    // NEVER if it does not happen within the range
+
+    size_t crossover(const char *name, Op op, size_t lo, size_t hi, const Config &config)
+    {
+        std::printf("%s (%s)\n", name, op_name(op));
+        size_t prev = lo;
+        size_t first_win = NEVER;
+        size_t n = lo;
+        while (n <= hi)
+        {
+            if (wins(" ", op, n, config))
+            {
+                if (first_win != NEVER)
+                {
+                    break;
+                }
+                first_win = n;
+            }
+            else
+            {
+                first_win = NEVER;
+                prev = n;
+            }
+            n += std::max<size_t>(1, n / 8);
+        }
+        if (first_win == NEVER || first_win == lo)
+        {
+            return first_win;
+        }
+
+        size_t step = std::max<size_t>(1, (first_win - prev) / 8);
+        n = prev + step;
+        while (n < first_win)
+        {
+            if (wins("~", op, n, config))
+            {
+                return n;
+            }
+            n += step;
+        }
+        return first_win;
+    }
+
+    // every threshold the tuner writes is at least the smallest size it measures, 8 limbs,
+    // which clears the minimums BigInt::set_thresholds enforces
+
+    bool parse_limbs(const char *s, size_t &n)
+    {
+        if (*s < '0' || *s > '9')
+        {
+            return false;
+        }
+        char *end = nullptr;
+        errno = 0;
+        unsigned long long v = std::strtoull(s, &end, 10);
+        if (*end != '\0' || errno == ERANGE || v < 8)
+        {
+            return false;
+        }
+        n = static_cast<size_t>(v);
+        return true;
+    }
+
+    bool write_header(const char *path, const char *kernels, const BigInt::Thresholds &t)
+    {
+        std::FILE *f = std::fopen(path, "w");
+        if (f == nullptr)
+        {
+            return false;
+        }
+        std::fprintf(f, "// generated by bigint_tune; delete it to go back to the built-in thresholds\n\n");
+        std::fprintf(f, "#pragma once\n\n");
+        std::fprintf(f, "// thresholds in limbs, used only while the library runs these kernels\n");
+        std::fprintf(f, "#define BIGINT_TUNED_KERNELS \"%s\"\n\n", kernels);
+        std::fprintf(f, "#define BIGINT_TUNED_KARATSUBA %zu\n", t.karatsuba);
+        std::fprintf(f, "#define BIGINT_TUNED_KARATSUBA_SQR %zu\n", t.karatsuba_sqr);
+        std::fprintf(f, "#define BIGINT_TUNED_TOOM3 %zu\n", t.toom3);
+        std::fprintf(f, "#define BIGINT_TUNED_TOOM4 %zu\n", t.toom4);
+        std::fprintf(f, "#define BIGINT_TUNED_NTT %zu\n", t.ntt);
+        std::fprintf(f, "#define BIGINT_TUNED_BURNIKEL_ZIEGLER %zu\n", t.burnikel_ziegler);
+        return std::fclose(f) == 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *out = "bigint_tuned.hpp";
+    size_t max_limbs = 131072;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            out = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--max-limbs") == 0 && i + 1 < argc && parse_limbs(argv[i + 1], max_limbs))
+        {
+            i += 1;
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [-o path] [--max-limbs n]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // the results only hold for the kernel set they were measured with; the library ignores
+    // the header when it runs on a different one
+
+    const char *kernels = BigInt::kernel_set();
+    std::printf("kernels: %s\n\n", kernels);
+
+    // each stage runs with everything above it switched off and everything below it tuned
+
+    const BigInt::Thresholds defaults = BigInt::default_thresholds();
+    BigInt::Thresholds t = defaults;
+    t.toom3 = NEVER;
+    t.toom4 = NEVER;
+    t.ntt = NEVER;
+
+    size_t kara_hi = std::min<size_t>(512, max_limbs);
+    size_t k = crossover("karatsuba", Op::Mul, 8, kara_hi, [&](size_t n, bool use) {
+        BigInt::Thresholds c = t;
+        c.karatsuba = use ? n : n + 1;
+        return c;
+    });
+    t.karatsuba = k == NEVER ? kara_hi : k;
+
+    size_t ks = crossover("karatsuba", Op::Sqr, 8, kara_hi, [&](size_t n, bool use) {
+        BigInt::Thresholds c = t;
+        c.karatsuba_sqr = use ? n : n + 1;
+        return c;
+    });
+    t.karatsuba_sqr = ks == NEVER ? kara_hi : ks;
+
+    size_t t3 = crossover("toom-3", Op::Mul, 2u * t.karatsuba, max_limbs, [&](size_t n, bool use) {
+        BigInt::Thresholds c = t;
+        c.toom3 = use ? n : n + 1;
+        return c;
+    });
+    t.toom3 = t3;
+
+    size_t t4_lo = std::max(t3 == NEVER ? 4u * t.karatsuba : t3, size_t(16));
+    size_t t4 = crossover("toom-4", Op::Mul, t4_lo, max_limbs, [&](size_t n, bool use) {
+        BigInt::Thresholds c = t;
+        c.toom4 = use ? n : n + 1;
+        return c;
+    });
+    t.toom4 = t4;
+
+    size_t nt = crossover("ntt", Op::Mul, 256, max_limbs, [&](size_t n, bool use) {
+        BigInt::Thresholds c = t;
+        c.ntt = use ? n : n + 1;
+        return c;
+    });
+
+    // NTT not winning within the range keeps the built-in crossover, or the end of the range
+    // if that is further out; a Toom tier that never won stays out of the way of the ones
+    // that did
+
+    t.ntt = nt == NEVER ? std::max(defaults.ntt, max_limbs) : nt;
+    t.toom4 = std::min(t.toom4, t.ntt);
+    t.toom3 = std::min(t.toom3, t.toom4);
+
+    size_t bz = crossover("burnikel-ziegler", Op::Div, 8, std::min<size_t>(2048, max_limbs),
+                          [&](size_t n, bool use) {
+                              BigInt::Thresholds c = t;
+                              c.burnikel_ziegler = use ? n : n + 1;
+                              return c;
+                          });
+    t.burnikel_ziegler = bz == NEVER ? std::min<size_t>(2048, max_limbs) : bz;
+
+    std::printf("\nkaratsuba %zu, karatsuba_sqr %zu, toom3 %zu, toom4 %zu, ntt %zu, burnikel_ziegler %zu\n",
+                t.karatsuba, t.karatsuba_sqr, t.toom3, t.toom4, t.ntt, t.burnikel_ziegler);
+    if (!write_header(out, kernels, t))
+    {
+        std::perror(out);
+        return 1;
+    }
+    std::printf("wrote %s; rebuild the library to use it\n", out);
+    return 0;
+}